@@ -0,0 +1,180 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "thread.hpp"
+#include "utils/argument_pack.hpp"
+#include "utils/inline_invocable.hpp"
+#include "utils/wrapped_call.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Resumes a suspended coroutine from a callback queue.
+//
+// If the queue drops the call, the coroutine is resumed right away on the
+// dropping thread and co_await throws CallbackDroppedError.
+class ResumeCall final : public WrappedCall<void> {
+ public:
+  explicit ResumeCall(std::coroutine_handle<> handle) noexcept
+      : m_handle(handle) {}
+
+  void Perform() override {
+    SetValue();
+    m_handle.resume();
+  }
+
+  void Discard() noexcept override {
+    WrappedCall<void>::Discard();
+    m_handle.resume();
+  }
+
+ private:
+  std::coroutine_handle<> m_handle;
+};
+
+// Runs a callable on one thread and then resumes the awaiting coroutine on
+// another one, by queueing itself twice. Without an origin queue the
+// coroutine resumes on the thread that ran the callable.
+template <typename Ret, typename... Args>
+class AwaitedCall final : public WrappedCall<Ret> {
+ public:
+  AwaitedCall(const InlineInvocable<Ret, Args...>& callable, Args&&... args)
+      : m_callable(callable), m_args(std::forward<Args>(args)...) {}
+
+  void Suspend(std::coroutine_handle<> handle, ICallbackQueuePtr target,
+               ICallbackQueuePtr origin) {
+    m_handle = handle;
+    m_origin = std::move(origin);
+    target->addCallback(WrappedCallBasePtr(this));
+  }
+
+  void Perform() override {
+    if (m_performed) {
+      m_handle.resume();
+      return;
+    }
+    m_performed = true;
+    try {
+      if constexpr (std::is_void_v<Ret>) {
+        m_args.Apply(m_callable);
+        this->SetValue();
+      } else {
+        this->SetValue(m_args.Apply(m_callable));
+      }
+    } catch (const std::exception&) {
+      this->SetException(std::current_exception());
+    }
+    Continue();
+  }
+
+  void Discard() noexcept override {
+    if (m_performed) {
+      // The origin queue dropped the continuation, the result stays.
+      m_handle.resume();
+      return;
+    }
+    m_performed = true;
+    WrappedCall<Ret>::Discard();
+    Continue();
+  }
+
+ private:
+  void Continue() noexcept {
+    if (m_origin == nullptr) {
+      m_handle.resume();
+    } else {
+      std::exchange(m_origin, nullptr)->addCallback(WrappedCallBasePtr(this));
+    }
+  }
+
+  InlineInvocable<Ret, Args...> m_callable;
+  ArgumentPack<Args...> m_args;
+  std::coroutine_handle<> m_handle;
+  ICallbackQueuePtr m_origin;
+  bool m_performed{false};
+};
+
+}  // namespace utils
+
+// Awaitable that continues the awaiting coroutine on thread:
+//
+//   co_await eh::resume_on(worker);
+//
+// The coroutine is posted to the thread's callback queue as a regular call,
+// so no OS thread blocks while it waits for its turn. Awaiting the thread
+// the coroutine already runs on does not suspend.
+class ResumeOn {
+ public:
+  explicit ResumeOn(ThreadPtr thread) : m_thread(std::move(thread)) {}
+
+  bool await_ready() const noexcept { return m_thread->IsCurrent(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    m_call = utils::MakeIntrusive<utils::ResumeCall>(handle);
+    // The coroutine may run on the other thread before addCallback returns,
+    // nothing of the awaiter may be touched afterwards.
+    utils::WrappedCallBasePtr call = m_call;
+    m_thread->CallbackQueue()->addCallback(call);
+  }
+
+  // Throws utils::CallbackDroppedError if the queue dropped the call.
+  void await_resume() const {
+    if (m_call != nullptr) {
+      m_call->Retrieve();
+    }
+  }
+
+ private:
+  ThreadPtr m_thread;
+  utils::IntrusivePtr<utils::ResumeCall> m_call;
+};
+
+inline ResumeOn resume_on(const ThreadPtr& thread) { return ResumeOn(thread); }
+
+namespace delegates {
+
+// Awaitable returned by Delegate::InvokeOn. Runs the delegate on the target
+// thread, then resumes the awaiting coroutine on the eh::Thread it was
+// suspended on and returns the delegate's result or rethrows its
+// exception. A coroutine awaiting outside of eh::Threads resumes on the
+// target thread.
+template <typename Ret, typename... Args>
+class InvokeOnAwaiter {
+  using Call = utils::AwaitedCall<Ret, Args...>;
+
+ public:
+  InvokeOnAwaiter(ThreadPtr thread,
+                  const utils::InlineInvocable<Ret, Args...>& callable,
+                  Args&&... args)
+      : m_thread(std::move(thread)),
+        m_call(utils::MakeIntrusive<Call>(callable,
+                                          std::forward<Args>(args)...)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    utils::ICallbackQueuePtr origin;
+    if (const ThreadPtr th = Thread::Current(); th != nullptr) {
+      origin = th->CallbackQueue();
+    }
+    // Keeps the call alive until Suspend returns; the coroutine, and with
+    // it the awaiter, may be gone by then.
+    utils::IntrusivePtr<Call> call = m_call;
+    call->Suspend(handle, m_thread->CallbackQueue(), std::move(origin));
+  }
+
+  Ret await_resume() { return m_call->Retrieve(); }
+
+ private:
+  ThreadPtr m_thread;
+  utils::IntrusivePtr<Call> m_call;
+};
+
+}  // namespace delegates
+
+}  // namespace eh
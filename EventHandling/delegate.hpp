@@ -1,13 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
+#include "awaitable.hpp"
 #include "delegate_base.h"
-#include "utils/invocable_element.hpp"
+#include "utils/continuation_call.hpp"
+#include "utils/inline_invocable.hpp"
 #include "utils/ptr.hpp"
 #include "utils/wrapped_call.hpp"
 
@@ -19,6 +25,9 @@ namespace delegates {
 template <typename Ret, typename... Args>
 class DelegateExecutor;
 
+template <typename Ret, typename Arguments>
+struct DelegateBinder;
+
 template <typename Ret, typename... Args>
 class Delegate : public IDelegate<Ret, Args...> {
   using Type = Delegate<Ret, Args...>;
@@ -30,33 +39,99 @@ class Delegate : public IDelegate<Ret, Args...> {
         m_thread_id(std::this_thread::get_id()) {}
   Delegate(const Delegate& other)
       : m_invocable(other.m_invocable),
+        m_partner_id(other.m_partner_id),
         m_invoke_type(other.m_invoke_type),
-        m_thread_id(other.m_thread_id) {}
+        m_thread_id(other.m_thread_id),
+        m_priority(other.m_priority) {}
   Delegate(Delegate&& other)
       : m_invocable(std::move(other.m_invocable)),
+        m_partner_id(other.m_partner_id),
         m_invoke_type(other.m_invoke_type),
-        m_thread_id(other.m_thread_id) {}
+        m_thread_id(other.m_thread_id),
+        m_priority(other.m_priority) {}
+
+  Delegate& operator=(const Delegate& other) = default;
+  Delegate& operator=(Delegate&& other) = default;
 
   bool IsEmpty() const override { return m_invocable == nullptr; }
   void Reset() override { m_invocable.reset(); }
 
   void SetInvokeType(InvokeType type) override { m_invoke_type = type; }
   void SetThreadId(std::thread::id id) override { m_thread_id = id; }
+  void SetPriority(Priority priority) override { m_priority = priority; }
+
+  Ret Invoke(Args&&... args) override {
+    return std::as_const(*this).Invoke(std::forward<Args>(args)...);
+  }
+
+  Ret Invoke(Args&&... args) const {
+    if (IsEmpty()) {
+      throw DelegateException("Callable object is empty");
+    }
+    return m_invocable(std::forward<Args>(args)...);
+  }
+
+  // Awaitable running the delegate on thread without blocking the awaiting
+  // coroutine's thread:
+  //
+  //   int sum = co_await d.InvokeOn(worker, 1, 2);
+  //
+  // See InvokeOnAwaiter for where the coroutine resumes.
+  InvokeOnAwaiter<Ret, Args...> InvokeOn(const ThreadPtr& thread,
+                                         Args&&... args) const {
+    if (IsEmpty()) {
+      throw DelegateException("Callable object is empty");
+    }
+    return InvokeOnAwaiter<Ret, Args...>(thread, m_invocable,
+                                         std::forward<Args>(args)...);
+  }
 
-  Ret Invoke(Args&&... args) {
+  // Queues the delegate to thread and returns its future right away, to be
+  // waited for or continued on other threads without blocking any:
+  //
+  //   parse.QueueOn(parser, request).Then(db, store).Then(io, reply);
+  utils::Future<Ret> QueueOn(const ThreadPtr& thread, Args&&... args) const {
     if (IsEmpty()) {
       throw DelegateException("Callable object is empty");
     }
-    return m_invocable->invoke(std::forward<Args>(args)...);
+    auto call = utils::MakeIntrusive<utils::WrappedCallImpl<Ret, Args...>>(
+        m_invocable, std::forward<Args>(args)...);
+    utils::Future<Ret> future = call->GetFuture();
+    call->SetPriority(m_priority);
+    thread->CallbackQueue()->addCallback(call);
+    return future;
   }
 
+  // Two integer comparisons for function pointers and bound methods.
+  bool operator==(const Delegate& other) const {
+    return IsPartner(other) || m_invocable == other.m_invocable;
+  }
+  bool operator!=(const Delegate& other) const { return !(*this == other); }
+  using IDelegate<Ret, Args...>::operator==;
+  using IDelegate<Ret, Args...>::operator!=;
+
+  // Consistent with ==. A callable without operator== is only equal to
+  // copies of its own delegate, so such delegates hash their partner id.
+  std::size_t Hash() const noexcept {
+    if (m_invocable.IsComparable()) {
+      return m_invocable.Hash();
+    }
+    return IsEmpty() ? 0 : std::hash<std::uint64_t>{}(m_partner_id);
+  }
+
+  // True for copies of the same delegate, even if the callable itself
+  // cannot be compared.
   bool IsPartner(const Delegate& other) const {
     if (IsEmpty() || other.IsEmpty()) {
       return false;
     }
-    return m_invocable == other.m_invocable;
+    return m_partner_id == other.m_partner_id;
   }
 
+  // False when the callable did not fit into the inline buffer and had to
+  // be allocated, see utils::InlineInvocable.
+  bool IsInline() const { return m_invocable.IsInline(); }
+
   template <typename Ret0, typename... Args0>
   friend Delegate<Ret0, Args0...> delegate(
       ptr::FunctionPtr<Ret0, Args0...> func);
@@ -74,35 +149,44 @@ class Delegate : public IDelegate<Ret, Args...> {
 
   friend class DelegateExecutor<Ret, Args...>;
 
+  friend struct DelegateBinder<Ret, std::tuple<Args...>>;
+
+  friend class eh::Thread;
+
+  template <typename T>
+  friend class utils::Future;
+
   //friend class DelegateExecutor<Ret, Args...>;
 
  private:
-  explicit Delegate(const utils::InvocableBasePtr<Ret, Args...>& invocable)
-      : m_invocable(invocable),
+  explicit Delegate(utils::InlineInvocable<Ret, Args...>&& invocable)
+      : m_invocable(std::move(invocable)),
+        m_partner_id(NextPartnerId()),
         m_invoke_type(InvokeType::Auto),
         m_thread_id(std::this_thread::get_id()) {}
 
-  utils::InvocableBasePtr<Ret, Args...> m_invocable;
+  static std::uint64_t NextPartnerId() {
+    static std::atomic<std::uint64_t> next_id{1};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  utils::InlineInvocable<Ret, Args...> m_invocable;
+  std::uint64_t m_partner_id{0};
   InvokeType m_invoke_type{InvokeType::Auto};
   std::thread::id m_thread_id;
+  Priority m_priority{Priority::Normal};
 
  protected:
-  bool Equals(const IDelegate<Ret, Args...>& other) const {
-    const Type* other_casted = dynamic_cast<const Type*>(&other);
-    if (other_casted == nullptr) {
-      return false;
-    }
-    if (IsPartner(*other_casted)) {
-      return true;
-    }
-    return *m_invocable == *(other_casted->m_invocable);
+  const void* Kind() const override { return utils::TypeTag<Type>(); }
+
+  bool Equals(const IDelegate<Ret, Args...>& other) const override {
+    return *this == static_cast<const Type&>(other);
   }
 };
 
 template <typename Ret, typename... Args>
 Delegate<Ret, Args...> delegate(ptr::FunctionPtr<Ret, Args...> func) {
-  return Delegate<Ret, Args...>(
-      utils::InvocationElementFactory<Ret, Args...>::create(func));
+  return Delegate<Ret, Args...>(utils::InlineInvocable<Ret, Args...>(func));
 }
 
 template <typename Ret, typename... Args, typename Obj, typename Method,
@@ -110,7 +194,7 @@ template <typename Ret, typename... Args, typename Obj, typename Method,
               std::is_invocable_r_v<Ret, Method, Obj, Args...>>>
 Delegate<Ret, Args...> delegate(Obj* object, Method method) {
   return Delegate<Ret, Args...>(
-      utils::InvocationElementFactory<Ret, Args...>::create(object, method));
+      utils::InlineInvocable<Ret, Args...>(object, method));
 }
 
 template <
@@ -118,17 +202,101 @@ template <
     typename = std::enable_if_t<std::is_invocable_r_v<Ret, Callable, Args...>>>
 Delegate<Ret, Args...> delegate(Callable&& callable) {
   return Delegate<Ret, Args...>(
-      utils::InvocationElementFactory<Ret, Args...>::create(
-          std::forward<Callable>(callable)));
+      utils::InlineInvocable<Ret, Args...>(std::forward<Callable>(callable)));
+}
+
+template <typename Ret, typename... Args>
+struct DelegateBinder<Ret, std::tuple<Args...>> {
+  template <auto Function>
+  static Delegate<Ret, Args...> Bind() {
+    return Delegate<Ret, Args...>(
+        utils::InlineInvocable<Ret, Args...>::template Bind<Function>());
+  }
+
+  template <auto Method, typename Object>
+  static Delegate<Ret, Args...> Bind(Object* object) {
+    return Delegate<Ret, Args...>(
+        utils::InlineInvocable<Ret, Args...>::template Bind<Method>(object));
+  }
+};
+
+// Delegate calling Function, e.g. bind<&OnTick>(). The function is part of
+// the delegate's target type, so invoking it is one indirect jump into a
+// thunk that calls Function directly. The signature is taken from Function.
+// Such delegates equal each other when bound to the same function, but not
+// delegates created with delegate().
+template <auto Function>
+auto bind() {
+  using Traits = traits::FunctionPointer<decltype(Function)>;
+  static_assert(!Traits::is_pointer_member,
+                "member functions are bound with bind<&Class::Method>(object)");
+  return DelegateBinder<typename Traits::ReturnType,
+                        typename Traits::Arguments>::template Bind<Function>();
+}
+
+// Same for a member function, e.g. bind<&Clock::OnTick>(&clock).
+template <auto Method, typename Object>
+auto bind(Object* object) {
+  using Traits = traits::FunctionPointer<decltype(Method)>;
+  static_assert(Traits::is_pointer_member,
+                "free functions are bound with bind<&Function>()");
+  return DelegateBinder<typename Traits::ReturnType,
+                        typename Traits::Arguments>::template Bind<Method>(
+      object);
 }
 
 template <typename Ret, typename... Args>
 utils::WrappedCallBasePtr WrappDelegateInvoke(const Delegate<Ret, Args...>& d,
                                               Args&&... args) {
-  return std::make_shared<utils::WrappedCallImpl<Ret, Args...>>(
+  return utils::MakeIntrusive<utils::WrappedCallImpl<Ret, Args...>>(
       d.m_invocable, std::forward<Args>(args)...);
 }
 
 }  // namespace delegates
 
+namespace utils {
+
+template <typename T>
+template <typename U, typename Delegate>
+Future<U> Future<T>::ContinueWith(const std::shared_ptr<Thread>& thread,
+                                  const Delegate& continuation) {
+  if (continuation.IsEmpty()) {
+    throw delegates::DelegateException("Callable object is empty");
+  }
+  auto call = MakeIntrusive<ContinuationCall<T, U>>(continuation.m_invocable,
+                                                    thread->CallbackQueue());
+  Future<U> future = call->GetFuture();
+  call->SetPriority(continuation.m_priority);
+  call->Continue(std::move(m_call));
+  return future;
+}
+
+template <typename T>
+template <typename U>
+Future<U> Future<T>::Then(const std::shared_ptr<Thread>& thread,
+                          const delegates::Delegate<U, T>& continuation)
+  requires(!std::is_void_v<T>)
+{
+  return ContinueWith<U>(thread, continuation);
+}
+
+template <typename T>
+template <typename U>
+Future<U> Future<T>::Then(const std::shared_ptr<Thread>& thread,
+                          const delegates::Delegate<U>& continuation)
+  requires std::is_void_v<T>
+{
+  return ContinueWith<U>(thread, continuation);
+}
+
+}  // namespace utils
+
 }  // namespace eh
+
+template <typename Ret, typename... Args>
+struct std::hash<eh::delegates::Delegate<Ret, Args...>> {
+  std::size_t operator()(
+      const eh::delegates::Delegate<Ret, Args...>& d) const noexcept {
+    return d.Hash();
+  }
+};
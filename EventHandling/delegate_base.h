@@ -23,12 +23,18 @@ class IDelegate {
   virtual void Reset() = 0;
   virtual void SetInvokeType(InvokeType type) = 0;
   virtual void SetThreadId(std::thread::id id) = 0;
+  virtual void SetPriority(Priority priority) = 0;
 
   Ret operator()(Args&&... args) { return Invoke(std::forward<Args>(args)...); }
-  bool operator==(const IDelegate& other) const { return Equals(other); }
+  bool operator==(const IDelegate& other) const {
+    return Kind() == other.Kind() && Equals(other);
+  }
   bool operator!=(const IDelegate& other) const { return !(*this == other); }
 
  protected:
+  // Tag unique to the implementing class, see utils::TypeTag.
+  virtual const void* Kind() const = 0;
+  // Only called with a delegate of the same kind.
   virtual bool Equals(const IDelegate<Ret, Args...>& other) const = 0;
 
 };
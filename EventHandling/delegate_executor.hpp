@@ -1,8 +1,8 @@
 #pragma once
 
-#include <future>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "delegate.hpp"
 #include "delegate_internal_executor.hpp"
@@ -21,6 +21,25 @@ class DelegateExecutor {
 
  public:
   using ExecutedType = Delegate<Ret, Args...>;
+  using ConflatedCallPtr = utils::IntrusivePtr<utils::ConflatedCall<Args...>>;
+
+  // How Post hands a set of delegates over. Delegates that Execute would
+  // queue without waiting are grouped by callback queue and priority, and
+  // each group becomes one utils::FanOutCall. The others are executed one
+  // by one. A plan depends on the thread that made it, because of
+  // InvokeType::Auto.
+  struct FanOutPlan {
+    struct Group {
+      utils::ICallbackQueueWPtr queue;
+      const utils::ICallbackQueue* queue_id;
+      Priority priority;
+      std::shared_ptr<std::vector<utils::InlineInvocable<Ret, Args...>>>
+          callables;
+    };
+
+    std::vector<Group> groups;
+    std::vector<ExecutedType> others;
+  };
 
   DelegateExecutor()
       : m_use_event_system(false), m_default_executor(), m_executors() {}
@@ -41,33 +60,177 @@ class DelegateExecutor {
         m_executors(std::move(other.m_executors)) {}
 
   Ret Execute(const ExecutedType& d, Args&&... args) {
-    std::thread::id thread_id = d.m_thread_id;
-    InvokeType invoke_type = d.m_invoke_type;
-    if (invoke_type == InvokeType::Auto) {
-      if (thread_id == std::this_thread::get_id()) {
-        invoke_type = InvokeType::Direct;
-      } else {
-        invoke_type = InvokeType::Queued;
+    const InvokeType invoke_type = ResolveInvokeType(d);
+    m_last_status = utils::EnqueueStatus::Accepted;
+    if (invoke_type == InvokeType::Async) {
+      return m_async_executor.Execute(
+          d.m_invocable, std::forward<Args>(args)..., invoke_type);
+    }
+    if (QueuedExecutor* executor = FindQueuedExecutor(d.m_thread_id)) {
+      return ExecuteQueued(*executor, d, std::forward<Args>(args)...,
+                           invoke_type);
+    }
+    return m_default_executor.Execute(
+        d.m_invocable, std::forward<Args>(args)..., d.m_invoke_type);
+  }
+
+  // Queues d to its thread like Execute, but through call, which is
+  // created on first use: while call is still pending, only its arguments
+  // are replaced. Delegates that would not be queued are executed as
+  // usual. BlockQueued delegates do not wait here.
+  void ExecuteConflated(const ExecutedType& d, ConflatedCallPtr& call,
+                        Args&&... args)
+    requires std::is_void_v<Ret>
+  {
+    const InvokeType invoke_type = ResolveInvokeType(d);
+    QueuedExecutor* executor = nullptr;
+    if (invoke_type == InvokeType::Queued ||
+        invoke_type == InvokeType::BlockQueued) {
+      executor = FindQueuedExecutor(d.m_thread_id);
+    }
+    if (executor == nullptr) {
+      return Execute(d, std::forward<Args>(args)...);
+    }
+    if (call == nullptr) {
+      call = utils::MakeIntrusive<utils::ConflatedCall<Args...>>(
+          d.m_invocable);
+    }
+    executor->ExecuteConflated(call, std::forward<Args>(args)...,
+                               d.m_priority);
+    m_last_status = executor->LastEnqueueStatus();
+  }
+
+  void AddToPlan(FanOutPlan& plan, const ExecutedType& d)
+    requires std::is_void_v<Ret>
+  {
+    if (ResolveInvokeType(d) == InvokeType::Queued) {
+      QueuedExecutor* executor = FindQueuedExecutor(d.m_thread_id);
+      if (auto queue = executor != nullptr ? executor->Queue() : nullptr) {
+        for (auto& group : plan.groups) {
+          if (group.queue_id == queue.get() && group.priority == d.m_priority) {
+            group.callables->push_back(d.m_invocable.WeakCopy());
+            return;
+          }
+        }
+        plan.groups.push_back(typename FanOutPlan::Group{
+            queue, queue.get(), d.m_priority,
+            std::make_shared<std::vector<utils::InlineInvocable<Ret, Args...>>>(
+                1, d.m_invocable.WeakCopy())});
+        return;
       }
     }
-    if (m_executors.contains(thread_id)) {
-      return m_executors[thread_id].Execute(
-          d.m_invocable, std::forward<Args>(args)..., invoke_type);
+    plan.others.push_back(d);
+  }
+
+  // Queues one call per group of plan, then executes the other delegates.
+  // LastEnqueueStatus reports the worst status seen.
+  void Post(const FanOutPlan& plan, Args&&... args)
+    requires std::is_void_v<Ret>
+  {
+    utils::EnqueueStatus status = utils::EnqueueStatus::Accepted;
+    for (const auto& group : plan.groups) {
+      auto call = utils::MakeIntrusive<utils::FanOutCall<Args...>>(
+          group.callables, std::forward<Args>(args)...);
+      utils::ICallbackQueuePtr queue = group.queue.lock();
+      if (queue == nullptr) {
+        call->Perform();
+        continue;
+      }
+      call->SetPriority(group.priority);
+      status = utils::Worst(status, queue->addCallback(call));
+    }
+    for (const auto& d : plan.others) {
+      Execute(d, std::forward<Args>(args)...);
+      status = utils::Worst(status, m_last_status);
+    }
+    m_last_status = status;
+  }
+
+  // Runs the delegate on the EventSystem worker pool, see
+  // QueuedInternalExecutor::ExecuteAsyncFuture.
+  utils::Future<Ret> ExecuteAsync(const ExecutedType& d, Args&&... args) {
+    return QueuedExecutor::ExecuteAsyncFuture(d.m_invocable,
+                                              std::forward<Args>(args)...);
+  }
+
+  // Queues d to its thread like Execute, but returns its future instead of
+  // blocking for non-void Ret, see QueuedInternalExecutor::
+  // ExecuteQueuedFuture. Async delegates go to the worker pool, those that
+  // would not be queued are performed right away.
+  utils::Future<Ret> ExecuteQueuedFuture(const ExecutedType& d,
+                                         Args&&... args) {
+    m_last_status = utils::EnqueueStatus::Accepted;
+    switch (ResolveInvokeType(d)) {
+      case InvokeType::Async:
+        return ExecuteAsync(d, std::forward<Args>(args)...);
+      case InvokeType::Queued:
+      case InvokeType::BlockQueued:
+        if (QueuedExecutor* executor = FindQueuedExecutor(d.m_thread_id)) {
+          auto future = executor->ExecuteQueuedFuture(
+              d.m_invocable, std::forward<Args>(args)..., d.m_priority);
+          m_last_status = executor->LastEnqueueStatus();
+          return future;
+        }
+        break;
+      case InvokeType::Direct:
+      case InvokeType::Auto:
+        break;
+    }
+    return QueuedExecutor().ExecuteQueuedFuture(d.m_invocable,
+                                                std::forward<Args>(args)...);
+  }
+
+  // Outcome of handing the last executed delegate to its thread's queue;
+  // Accepted for delegates that were run directly.
+  utils::EnqueueStatus LastEnqueueStatus() const { return m_last_status; }
+
+ private:
+  static InvokeType ResolveInvokeType(const ExecutedType& d) {
+    if (d.m_invoke_type != InvokeType::Auto) {
+      return d.m_invoke_type;
+    }
+    return d.m_thread_id == std::this_thread::get_id() ? InvokeType::Direct
+                                                       : InvokeType::Queued;
+  }
+
+  QueuedExecutor* FindQueuedExecutor(std::thread::id thread_id) {
+    if (auto it = m_executors.find(thread_id); it != m_executors.end()) {
+      return &it->second;
     }
     if (m_use_event_system) {
+      // Posting back to the caller's own thread needs no registry.
+      if (thread_id == std::this_thread::get_id()) {
+        if (const ThreadPtr th = Thread::Current(); th != nullptr) {
+          return &(m_executors[thread_id] =
+                       QueuedExecutor(th->CallbackQueue()));
+        }
+      }
       if (auto th = Thread::FindRegistered(thread_id); th.has_value()) {
-        m_executors[thread_id] = QueuedExecutor(th.value()->CallbackQueue());
-        return m_executors[thread_id].Execute(
-            d.m_invocable, std::forward<Args>(args)..., invoke_type);
+        return &(m_executors[thread_id] =
+                     QueuedExecutor(th.value()->CallbackQueue()));
       }
     }
-    return m_default_executor.Execute(
-        d.m_invocable, std::forward<Args>(args)..., d.m_invoke_type);
+    return nullptr;
+  }
+
+  Ret ExecuteQueued(QueuedExecutor& executor, const ExecutedType& d,
+                    Args&&... args, InvokeType invoke_type) {
+    if constexpr (std::is_void_v<Ret>) {
+      executor.Execute(d.m_invocable, std::forward<Args>(args)..., invoke_type,
+                       d.m_priority);
+      m_last_status = executor.LastEnqueueStatus();
+    } else {
+      Ret result = executor.Execute(d.m_invocable, std::forward<Args>(args)...,
+                                    invoke_type, d.m_priority);
+      m_last_status = executor.LastEnqueueStatus();
+      return result;
+    }
   }
 
- private:
   bool m_use_event_system;
+  utils::EnqueueStatus m_last_status{utils::EnqueueStatus::Accepted};
   DefaultExecutor m_default_executor;
+  QueuedExecutor m_async_executor;
   std::unordered_map<std::thread::id, QueuedExecutor> m_executors;
 };
 
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <future>
 #include <memory>
 #include <thread>
 
+#include "event_system.h"
 #include "thread.hpp"
-#include "utils/invocable_element.hpp"
+#include "utils/inline_invocable.hpp"
 #include "utils/wrapped_call.hpp"
 #include "delegate_invoke_type.h"
 
@@ -16,8 +16,17 @@ namespace delegates {
 template <typename Ret, typename... Args>
 class InternalExecutor {
  public:
-  virtual Ret Execute(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-                      Args&&... args, InvokeType invoke_type) = 0;
+  Ret Execute(const utils::InlineInvocable<Ret, Args...>& invocable,
+              Args&&... args, InvokeType invoke_type,
+              Priority priority = Priority::Normal) {
+    return DoExecute(invocable, std::forward<Args>(args)..., invoke_type,
+                     priority);
+  }
+
+ protected:
+  virtual Ret DoExecute(const utils::InlineInvocable<Ret, Args...>& invocable,
+                        Args&&... args, InvokeType invoke_type,
+                        Priority priority) = 0;
 };
 
 template <typename Ret, typename... Args>
@@ -25,10 +34,11 @@ using ExecutorPtr = std::shared_ptr<InternalExecutor<Ret, Args...>>;
 
 template <typename Ret, typename... Args>
 class DefaultInternalExecutor : public InternalExecutor<Ret, Args...> {
- public:
-  Ret Execute(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-              Args&&... args, InvokeType /*invoke_type*/) override {
-    return invocable->invoke(std::forward<Args>(args)...);
+ private:
+  Ret DoExecute(const utils::InlineInvocable<Ret, Args...>& invocable,
+                Args&&... args, InvokeType /*invoke_type*/,
+                Priority /*priority*/) override {
+    return invocable(std::forward<Args>(args)...);
   }
 };
 
@@ -41,10 +51,79 @@ class QueuedInternalExecutor : public InternalExecutor<Ret, Args...> {
   explicit QueuedInternalExecutor(const utils::ICallbackQueuePtr& callback_queue)
       : m_callback_queue(callback_queue) {}
   QueuedInternalExecutor(const QueuedInternalExecutor& other)
-      : m_callback_queue(other.m_callback_queue) {}
+      : m_callback_queue(other.m_callback_queue),
+        m_last_status(other.m_last_status) {}
+
+  // Hands call to the callback queue unless it is still pending there, in
+  // which case only its arguments are replaced. Without a queue the call is
+  // performed right away.
+  void ExecuteConflated(
+      const utils::IntrusivePtr<utils::ConflatedCall<Args...>>& call,
+      Args&&... args, Priority priority = Priority::Normal)
+    requires std::is_void_v<Ret>
+  {
+    m_last_status = utils::EnqueueStatus::Accepted;
+    if (!call->Update(std::forward<Args>(args)...)) {
+      return;
+    }
+    utils::ICallbackQueuePtr queue = m_callback_queue.lock();
+    if (queue == nullptr) {
+      call->Perform();
+      return;
+    }
+    call->SetPriority(priority);
+    m_last_status = queue->addCallback(call);
+  }
+
+  // The non-blocking counterpart of BlockQueued, also for non-void Ret:
+  // hands the call to the callback queue and returns its future right away,
+  // see Future::Then. Without a queue the call is performed right away.
+  utils::Future<Ret> ExecuteQueuedFuture(
+      const utils::InlineInvocable<Ret, Args...>& invocable, Args&&... args,
+      Priority priority = Priority::Normal) {
+    m_last_status = utils::EnqueueStatus::Accepted;
+    utils::IntrusivePtr<WrapInvoke> call = utils::MakeIntrusive<WrapInvoke>(
+        invocable, std::forward<Args>(args)...);
+    utils::Future<Ret> future = call->GetFuture();
+    utils::ICallbackQueuePtr queue = m_callback_queue.lock();
+    if (queue == nullptr) {
+      call->Perform();
+      return future;
+    }
+    call->SetPriority(priority);
+    m_last_status = queue->addCallback(call);
+    return future;
+  }
+
+  // Null once the queue is gone.
+  utils::ICallbackQueuePtr Queue() const { return m_callback_queue.lock(); }
+
+  // Outcome of handing the last Queued or BlockQueued call to the callback
+  // queue. A BlockQueued call that was not accepted throws
+  // utils::CallbackDroppedError from Execute.
+  utils::EnqueueStatus LastEnqueueStatus() const { return m_last_status; }
+
+  // Starts the call on the EventSystem worker pool and returns without
+  // waiting for it. Without an initialized EventSystem there is no pool,
+  // the call is performed right away.
+  static utils::Future<Ret> ExecuteAsyncFuture(
+      const utils::InlineInvocable<Ret, Args...>& invocable, Args&&... args) {
+    utils::IntrusivePtr<WrapInvoke> call = utils::MakeIntrusive<WrapInvoke>(
+        invocable, std::forward<Args>(args)...);
+    auto future = call->GetFuture();
+    if (EventSystem::IsInitialized()) {
+      EventSystem::Instance().Workers().Submit(call);
+    } else {
+      call->Perform();
+    }
+    return future;
+  }
 
-  Ret Execute(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-              Args&&... args, InvokeType invoke_type) override {
+ private:
+  Ret DoExecute(const utils::InlineInvocable<Ret, Args...>& invocable,
+                Args&&... args, InvokeType invoke_type,
+                Priority priority) override {
+    m_last_status = utils::EnqueueStatus::Accepted;
     if (invoke_type == InvokeType::Auto) {
       invoke_type = InvokeType::Direct;
     }
@@ -66,51 +145,73 @@ class QueuedInternalExecutor : public InternalExecutor<Ret, Args...> {
 
       case InvokeType::Queued:
         if constexpr (std::is_same_v<Ret, void>) {
-          ExecuteQueued(invocable, std::forward<Args>(args)...);
+          ExecuteQueued(invocable, std::forward<Args>(args)..., priority);
           return;
         } else {
           [[fallthrough]];
         }
 
       case InvokeType::BlockQueued:
-        return ExecuteBlockQueued(invocable, std::forward<Args>(args)...);
+        return ExecuteBlockQueued(invocable, std::forward<Args>(args)...,
+                                  priority);
     }
-    return invocable->invoke(std::forward<Args>(args)...);
+    return invocable(std::forward<Args>(args)...);
   }
 
- private:
   utils::ICallbackQueuePtr m_callback_queue_locked;
   utils::ICallbackQueueWPtr m_callback_queue;
+  utils::EnqueueStatus m_last_status{utils::EnqueueStatus::Accepted};
 
-  Ret ExecuteDirect(const utils::InvocableBasePtr<Ret, Args...>& invocable,
+  Ret ExecuteDirect(const utils::InlineInvocable<Ret, Args...>& invocable,
                     Args&&... args) {
-    return invocable->invoke(std::forward<Args>(args)...);
+    return invocable(std::forward<Args>(args)...);
   }
 
-  Ret ExecuteAsync(const utils::InvocableBasePtr<Ret, Args...>& invocable,
+  // Waits for the result, except for void calls on the EventSystem worker
+  // pool: like Queued void calls they report nothing back, an exception
+  // they throw is dropped. Use ExecuteAsyncFuture to observe it.
+  Ret ExecuteAsync(const utils::InlineInvocable<Ret, Args...>& invocable,
                    Args&&... args) {
+    if (EventSystem::IsInitialized()) {
+      if constexpr (std::is_void_v<Ret>) {
+        // Nothing to wait for, the call finishes in the background.
+        EventSystem::Instance().Workers().Submit(
+            utils::MakeIntrusive<WrapInvoke>(invocable,
+                                             std::forward<Args>(args)...));
+        return;
+      }
+      // A worker waiting for its own pool could starve it, run inline.
+      if (EventSystem::Instance().Workers().IsWorkerThread()) {
+        return ExecuteDirect(invocable, std::forward<Args>(args)...);
+      }
+      return ExecuteAsyncFuture(invocable, std::forward<Args>(args)...).get();
+    }
     WrapInvoke call(invocable, std::forward<Args>(args)...);
-    auto future = call.GetFuture();
-    std::jthread th(&WrapInvoke::Perform, std::ref(call));
-    return future.get();
+    {
+      std::jthread th(&WrapInvoke::Perform, std::ref(call));
+    }
+    return call.Retrieve();
   }
 
-  void ExecuteQueued(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-                     Args&&... args) {
-    std::shared_ptr<WrapInvoke> call =
-        std::make_shared<WrapInvoke>(invocable, std::forward<Args>(args)...);
-    m_callback_queue_locked->addCallback(call);
+  void ExecuteQueued(const utils::InlineInvocable<Ret, Args...>& invocable,
+                     Args&&... args, Priority priority) {
+    utils::IntrusivePtr<WrapInvoke> call = utils::MakeIntrusive<WrapInvoke>(
+        invocable, std::forward<Args>(args)...);
+    call->SetPriority(priority);
+    m_last_status = m_callback_queue_locked->addCallback(call);
     m_callback_queue_locked.reset();
   }
 
-  Ret ExecuteBlockQueued(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-                         Args&&... args) {
-    std::shared_ptr<WrapInvoke> call =
-        std::make_shared<WrapInvoke>(invocable, std::forward<Args>(args)...);
-    m_callback_queue_locked->addCallback(call);
-    auto future = call->GetFuture();
+  Ret ExecuteBlockQueued(
+      const utils::InlineInvocable<Ret, Args...>& invocable, Args&&... args,
+      Priority priority) {
+    utils::IntrusivePtr<WrapInvoke> call = utils::MakeIntrusive<WrapInvoke>(
+        invocable, std::forward<Args>(args)...);
+    call->SetPriority(priority);
+    m_last_status = m_callback_queue_locked->addCallback(call);
     m_callback_queue_locked.reset();
-    return future.get();
+    call->Wait();
+    return call->Retrieve();
   }
 };
 
@@ -124,13 +225,18 @@ class ThreadedInternalExecutor : public InternalExecutor<Ret, Args...> {
   ThreadedInternalExecutor(const ThreadedInternalExecutor& other)
       : m_thread(other.m_thread), m_executor(other.m_executor) {}
 
-  Ret Execute(const utils::InvocableBasePtr<Ret, Args...>& invocable,
-              Args&&... args, InvokeType invoke_type) override {
-    return m_executor.Execute(invocable, std::forward<Args>(args)...,
-                              invoke_type);
+  utils::EnqueueStatus LastEnqueueStatus() const {
+    return m_executor.LastEnqueueStatus();
   }
 
  private:
+  Ret DoExecute(const utils::InlineInvocable<Ret, Args...>& invocable,
+                Args&&... args, InvokeType invoke_type,
+                Priority priority) override {
+    return m_executor.Execute(invocable, std::forward<Args>(args)...,
+                              invoke_type, priority);
+  }
+
   ThreadPtr m_thread;
   QueuedInternalExecutor<Ret, Args...> m_executor;
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "utils/priority.hpp"
+
 namespace eh {
 
 namespace delegates {
@@ -12,6 +14,8 @@ enum class InvokeType {
   Auto 
 };
 
+using Priority = utils::Priority;
+
 }  // namespace delegates
 
 }  // namespace eh
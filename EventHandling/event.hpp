@@ -6,7 +6,7 @@ namespace eh {
 
 namespace events {
 
-enum class TriggerType { Synchronous, Asynchronous };
+enum class TriggerType { Synchronous, Asynchronous, Conflating };
 
 template <typename... Args>
 class IEvent {
@@ -14,19 +14,33 @@ class IEvent {
   virtual ~IEvent() {}
 
   virtual bool HasHandlers() const = 0;
-  virtual void AddHandler(const EventHandler<Args...>& handler) = 0;
+  virtual delegates::Connection AddHandler(
+      const EventHandler<Args...>& handler) = 0;
+  // Removes the handler added by the AddHandler call that returned
+  // connection, in O(1). Returns false if it was removed already.
+  virtual bool RemoveHandler(const delegates::Connection& connection) = 0;
   virtual void RemoveHandler(const EventHandler<Args...>& handler) = 0;
   virtual void SyncTrigger(Args&&... args) = 0;
-  virtual void AsyncTrigger(Args&&... args) = 0;
+  // Reports the worst utils::EnqueueStatus among the handlers that were
+  // queued to other threads.
+  virtual utils::EnqueueStatus AsyncTrigger(Args&&... args) = 0;
+  // AsyncTrigger for state-like events where only the latest value
+  // matters: a handler whose previous call has not run yet gets its
+  // arguments replaced instead of another call queued.
+  virtual utils::EnqueueStatus ConflatingTrigger(Args&&... args) = 0;
   virtual TriggerType GetTriggerType() const = 0;
   virtual void SetTriggerType(TriggerType trigger_type) = 0;
 
-  void Trigger(Args&&... args) const {
-    switch (TriggerType()) {
+  void Trigger(Args&&... args) {
+    switch (GetTriggerType()) {
       case TriggerType::Synchronous:
         return SyncTrigger(std::forward<Args>(args)...);
       case TriggerType::Asynchronous:
-        return AsyncTrigger(std::forward<Args>(args)...);
+        AsyncTrigger(std::forward<Args>(args)...);
+        return;
+      case TriggerType::Conflating:
+        ConflatingTrigger(std::forward<Args>(args)...);
+        return;
       default:
         return SyncTrigger(std::forward<Args>(args)...);
     }
@@ -42,8 +56,12 @@ class Event : public IEvent<Args...> {
 
   bool HasHandlers() const override { return !m_handlers.IsEmpty(); }
 
-  void AddHandler(const EventHandler<Args...>& handler) override {
-    m_handlers += handler;
+  delegates::Connection AddHandler(
+      const EventHandler<Args...>& handler) override {
+    return m_handlers += handler;
+  }
+  bool RemoveHandler(const delegates::Connection& connection) override {
+    return m_handlers.Disconnect(connection);
   }
   void RemoveHandler(const EventHandler<Args...>& handler) override {
     m_handlers -= handler;
@@ -53,9 +71,12 @@ class Event : public IEvent<Args...> {
     m_handlers.SetUseExecutor(false);
     m_handlers.Invoke(std::forward<Args>(args)...);
   }
-  void AsyncTrigger(Args&&... args) override {
+  utils::EnqueueStatus AsyncTrigger(Args&&... args) override {
     m_handlers.SetUseExecutor(true);
-    m_handlers.Invoke(std::forward<Args>(args)...);
+    return m_handlers.Dispatch(std::forward<Args>(args)...);
+  }
+  utils::EnqueueStatus ConflatingTrigger(Args&&... args) override {
+    return m_handlers.Conflate(std::forward<Args>(args)...);
   }
 
   TriggerType GetTriggerType() const override { return m_trigger_type; }
@@ -26,14 +26,14 @@ template <typename... Args, typename Obj, typename Method,
           typename = std::enable_if_t<
               std::is_invocable_r_v<void, Method, Obj, Args...>>>
 EventHandler<Args...> handler(Obj* object, Method method) {
-  return delegates::delegate<void, Args..., Obj, Method>(object, method);
+  return delegates::delegate<void, Args...>(object, method);
 }
 
 template <
     typename... Args, typename Callable,
     typename = std::enable_if_t<std::is_invocable_r_v<void, Callable, Args...>>>
 EventHandler<Args...> handler(Callable&& callable) {
-  return delegates::delegate<void, Args..., Callable>(
+  return delegates::delegate<void, Args...>(
       std::forward<Callable>(callable));
 }
 
@@ -29,6 +29,8 @@ EventSystem& EventSystem::Instance() {
   return *instance;
 }
 
+bool EventSystem::IsInitialized() { return instance != nullptr; }
+
 ThreadPtr EventSystem::MainThread() {
 #ifdef __GNUC__
   std::lock_guard<std::mutex> g(main_mutex);
@@ -50,7 +52,7 @@ ThreadPtr EventSystem::MainThread() {
 #endif  // __GNUC__
 }
 
-void EventSystem::Init() {
+void EventSystem::Init(std::size_t worker_count) {
 #ifdef __GNUC__
   std::lock_guard<std::mutex> g(main_mutex);
   main_thread = Thread::Create();
@@ -60,7 +62,7 @@ void EventSystem::Init() {
   main_thread.load()->Start();
 #endif  // __GNUC__
 
-  instance = std::make_unique<EventSystem>();
+  instance = std::make_unique<EventSystem>(worker_count);
 
 #ifdef __GNUC__
   instance->RegisterThread(main_thread);
@@ -75,40 +77,63 @@ void EventSystem::Release() {
   {
     std::lock_guard<std::mutex> g(main_mutex);
     main_thread->Stop();
+    main_thread = nullptr;
   }
 #else
-  main_thread.load()->Stop();
+  main_thread.exchange(nullptr)->Stop();
 #endif  // __GNUC__
 
-  instance.release();
+  // Stops the registered threads and joins the worker pool.
+  instance.reset();
 }
 
+EventSystem::EventSystem(std::size_t worker_count)
+    : m_workers(worker_count) {}
+
 EventSystem::~EventSystem() {
-  std::lock_guard<std::recursive_mutex> g(m_mutex);
-  for (auto& th : m_threads) {
+  const ThreadMap threads = *m_threads.Read();
+  m_threads.Store({});
+  for (const auto& th : threads) {
     th.second->Stop();
-    th.second = nullptr;
   }
 }
 
+WorkerPool& EventSystem::Workers() { return m_workers; }
+
 void EventSystem::RegisterThread(const ThreadPtr& th) {
   if (th == nullptr) {
     return;
   }
-  std::lock_guard<std::recursive_mutex> g(m_mutex);
-  if (!m_threads.contains(th->ThreadId())) {
-    m_threads[th->ThreadId()] = th;
+  m_threads.Modify([&th](ThreadMap& threads) {
+    return threads.try_emplace(th->ThreadId(), th).second;
+  });
+}
+
+std::optional<ThreadPtr> EventSystem::FindRegisteredThread(
+    std::thread::id id) const {
+  const auto threads = m_threads.Read();
+  if (auto it = threads->find(id); it != threads->end()) {
+    return it->second;
   }
+  return std::nullopt;
 }
 
 ThreadPtr EventSystem::GetRegisteredThread(std::thread::id id) {
-  std::lock_guard<std::recursive_mutex> g(m_mutex);
-  return m_threads.at(id);
+  return m_threads.Read()->at(id);
 }
 
 bool EventSystem::ContainsRegistererdThread(std::thread::id id) const {
-  std::lock_guard<std::recursive_mutex> g(m_mutex);
-  return m_threads.contains(id);
+  return m_threads.Read()->contains(id);
+}
+
+std::unordered_map<std::thread::id, ThreadMetrics> EventSystem::Metrics()
+    const {
+  const auto threads = m_threads.Read();
+  std::unordered_map<std::thread::id, ThreadMetrics> metrics;
+  for (const auto& [id, th] : *threads) {
+    metrics.emplace(id, th->Metrics());
+  }
+  return metrics;
 }
 
 }  // namespace eh
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <optional>
 #include <stdexcept>
 #include <unordered_map>
 
 #include "thread.hpp"
+#include "utils/snapshot_cell.hpp"
+#include "worker_pool.hpp"
 
 namespace eh {
 
@@ -15,20 +18,34 @@ class EventSystemError : std::runtime_error {
 class EventSystem {
  public:
   static EventSystem& Instance();
+  static bool IsInitialized();
   static ThreadPtr MainThread();
-  static void Init();
+  // worker_count sizes the pool running InvokeType::Async calls, 0 uses
+  // std::thread::hardware_concurrency().
+  static void Init(std::size_t worker_count = 0);
+  // Stops the main thread and all registered threads and joins the
+  // worker pool.
   static void Release();
 
-  EventSystem() = default;
+  explicit EventSystem(std::size_t worker_count = 0);
   ~EventSystem();
 
+  WorkerPool& Workers();
+
+  // Registration copies the registry, lookups never lock.
   void RegisterThread(const ThreadPtr& th);
+  std::optional<ThreadPtr> FindRegisteredThread(std::thread::id id) const;
   ThreadPtr GetRegisteredThread(std::thread::id id);
   bool ContainsRegistererdThread(std::thread::id id) const;
 
+  // Thread::Metrics of every registered thread.
+  std::unordered_map<std::thread::id, ThreadMetrics> Metrics() const;
+
  private:
-  mutable std::recursive_mutex m_mutex;
-  std::unordered_map<std::thread::id, ThreadPtr> m_threads;
+  using ThreadMap = std::unordered_map<std::thread::id, ThreadPtr>;
+
+  utils::SnapshotCell<ThreadMap> m_threads;
+  WorkerPool m_workers;
 };
 
 }  // namespace eh
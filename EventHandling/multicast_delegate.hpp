@@ -1,144 +1,334 @@
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <mutex>
-#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "delegate.hpp"
 #include "delegate_base.h"
 #include "delegate_executor.hpp"
+#include "utils/slot_table.hpp"
 
 namespace eh {
 
 namespace delegates {
 
+// Identifies a handler added to a MulticastDelegate, see Disconnect.
+using Connection = utils::SlotKey;
+
 namespace {
 
 template <typename Ret, typename... Args>
 struct MulticastDelegateCore {
   using DelegateShared = Delegate<Ret, Args...>;
+  using Handlers = utils::SlotTable<DelegateShared>;
   using Mutex = std::recursive_mutex;
   using Executor = DelegateExecutor<Ret, Args...>;
+  using FanOutPlan = typename Executor::FanOutPlan;
 
-  std::list<DelegateShared> handlers;
-  bool use_executor{false};
-  Executor executor;
-  mutable Mutex coreMutex;
+  // Call reused by Conflate for the connection it was created for.
+  struct ConflatedSlot {
+    std::uint32_t generation{0};
+    typename Executor::ConflatedCallPtr call;
+  };
 
-  inline std::list<DelegateShared>::iterator find(
-      const Delegate<Ret, Args...>& d) {
-    return std::find(handlers.begin(), handlers.end(), d);
-  }
+  Handlers handlers;
+  // Serializes changes, so the index always matches the handlers.
+  std::mutex writeMutex;
+  // Handlers by hash, for removing them by value. The handlers of a hash
+  // form a list in the order they were added, linked through `links`, so
+  // any of them is unlinked in O(1) and -= meets the oldest of equal
+  // handlers first.
+  struct Bucket {
+    std::uint32_t head;
+    std::uint32_t tail;
+  };
+  struct Link {
+    Connection connection;
+    std::size_t hash{0};
+    std::uint32_t prev{kNoLink};
+    std::uint32_t next{kNoLink};
+  };
+  static constexpr std::uint32_t kNoLink =
+      std::numeric_limits<std::uint32_t>::max();
+  std::unordered_map<std::size_t, Bucket> index;
+  // By Connection::index.
+  std::vector<Link> links;
+  // Bumped by every change of the handlers.
+  std::atomic<std::uint64_t> version{0};
+  std::atomic_bool use_executor{false};
+  // The executor caches per-thread queues and is not thread safe.
+  Executor executor{true};
+  // Conflate's calls by Connection::index, guarded by executorMutex.
+  std::vector<ConflatedSlot> conflated;
+  // Dispatch's plan for the handlers at plan_version, made by plan_thread;
+  // guarded by executorMutex.
+  std::shared_ptr<const FanOutPlan> plan;
+  std::uint64_t plan_version{0};
+  std::thread::id plan_thread;
+  mutable Mutex executorMutex;
 };
 
 }  // namespace
 
+// Invoking never locks or allocates: it walks the handlers that were added
+// when it started. A handler removed meanwhile, also by a handler, is
+// skipped if it has not run yet; one added meanwhile only runs from the
+// next invocation on.
 template <typename Ret, typename... Args>
 class MulticastDelegate : public IDelegate<Ret, Args...> {
+  using FanOutPlan = typename MulticastDelegateCore<Ret, Args...>::FanOutPlan;
 
  public:
   MulticastDelegate() noexcept = default;
   MulticastDelegate(const MulticastDelegate& other) {
-    std::lock_guard<Mutex> g(other.m_core.coreMutex);
-    std::copy(other.m_core.handlers.begin(), other.m_core.handlers.last(),
-              m_core.begin());
+    for (auto& handler : other.m_core.handlers.LiveValues()) {
+      Connect(std::move(handler));
+    }
   }
-  MulticastDelegate(MulticastDelegate&& other) noexcept {
-    std::lock_guard<Mutex> g(other.m_core.coreMutex);
-    m_core.handlers = std::move(other.m_core.handlers);
+  MulticastDelegate(MulticastDelegate&& other) : MulticastDelegate(other) {
+    other.Reset();
   }
 
   MulticastDelegate(const Delegate<Ret, Args...>&& d) : MulticastDelegate() {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    m_core.handlers.push_back(d);
-  }
-
-  ~MulticastDelegate() { 
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    m_core.handlers.clear();
+    *this += d;
   }
 
   void SetUseExecutor(bool use_executor) {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
     m_core.use_executor = use_executor;
   }
 
-  bool UseExecutor() const {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    return m_core.use_executor;
-  }
+  bool UseExecutor() const { return m_core.use_executor; }
 
   Ret Invoke(Args&&... args) override {
-    if (IsEmpty()) {
+    const auto handlers = m_core.handlers.Read();
+    std::size_t last = handlers.Size();
+    while (last > 0 && !handlers.IsAlive(last - 1)) {
+      --last;
+    }
+    if (last == 0) {
       throw DelegateException("Multicast Delegate is empty");
     }
-    auto it = m_core.handlers.begin();
-    for (; it != --m_core.handlers.end(); ++it) {
-      std::lock_guard<Mutex> g(m_core.coreMutex);
-      if (m_core.use_executor) {
-        m_core.executor.Execute(*it, std::forward<Args>(args)...);
+    --last;
+    const bool use_executor = m_core.use_executor;
+    for (std::size_t i = 0; i < last; ++i) {
+      if (!handlers.IsAlive(i)) {
+        continue;
+      }
+      if (use_executor) {
+        Execute(handlers[i], std::forward<Args>(args)...);
       } else {
-        it->Invoke(std::forward<Args>(args)...);
+        handlers[i].Invoke(std::forward<Args>(args)...);
       }
     }
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    if (m_core.use_executor) {
-      return m_core.executor.Execute(*it, std::forward<Args>(args)...);
+    // The last handler provides the result, even if it was removed by now.
+    if (use_executor) {
+      return Execute(handlers[last], std::forward<Args>(args)...);
     } else {
-      return it->Invoke(std::forward<Args>(args)...);
+      return handlers[last].Invoke(std::forward<Args>(args)...);
     }
-    //return it->Invoke(std::forward<Args>(args)...);
-    //return m_core.executor.Execute(*it, std::forward<Args>(args)...);
   }
 
-  bool IsEmpty() const override {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    return m_core.handlers.empty();
+  // Runs every handler through the executor, as Invoke does after
+  // SetUseExecutor(true), and returns the worst enqueue status seen.
+  // Handlers queued to the same thread are posted as one call that holds
+  // the arguments once, so queue traffic grows with the number of target
+  // threads rather than handlers. The grouping is cached until the handlers
+  // change or another thread dispatches.
+  utils::EnqueueStatus Dispatch(Args&&... args)
+    requires std::is_void_v<Ret>
+  {
+    if (IsEmpty()) {
+      throw DelegateException("Multicast Delegate is empty");
+    }
+    std::lock_guard<Mutex> g(m_core.executorMutex);
+    // Handlers run directly may change the handlers and replace the plan.
+    std::shared_ptr<const FanOutPlan> plan = CurrentPlan();
+    m_core.executor.Post(*plan, std::forward<Args>(args)...);
+    return m_core.executor.LastEnqueueStatus();
   }
 
+  // Like Dispatch, but a handler whose previous call is still waiting in
+  // its thread's queue gets that call's arguments replaced instead of
+  // another call queued, so it only sees the latest arguments and each
+  // handler has at most one call pending.
+  utils::EnqueueStatus Conflate(Args&&... args)
+    requires std::is_void_v<Ret>
+  {
+    if (IsEmpty()) {
+      throw DelegateException("Multicast Delegate is empty");
+    }
+    const auto handlers = m_core.handlers.Read();
+    utils::EnqueueStatus status = utils::EnqueueStatus::Accepted;
+    std::lock_guard<Mutex> g(m_core.executorMutex);
+    for (std::size_t i = 0; i < handlers.Size(); ++i) {
+      if (!handlers.IsAlive(i)) {
+        continue;
+      }
+      const Connection connection = handlers.Key(i);
+      if (connection.index >= m_core.conflated.size()) {
+        m_core.conflated.resize(connection.index + 1);
+      }
+      // The index may have been reused by another connection since.
+      auto& slot = m_core.conflated[connection.index];
+      if (slot.generation != connection.generation) {
+        slot.generation = connection.generation;
+        slot.call.reset();
+      }
+      m_core.executor.ExecuteConflated(handlers[i], slot.call,
+                                       std::forward<Args>(args)...);
+      status = utils::Worst(status, m_core.executor.LastEnqueueStatus());
+    }
+    return status;
+  }
+
+  bool IsEmpty() const override { return m_core.handlers.LiveCount() == 0; }
+
+  // Invalidates all connections.
   void Reset() override {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    m_core.handlers.clear();
+    std::lock_guard<std::mutex> g(m_core.writeMutex);
+    m_core.handlers.Clear();
+    m_core.index.clear();
+    m_core.links.clear();
+    m_core.version.fetch_add(1, std::memory_order_release);
   }
 
   void SetInvokeType(InvokeType /*type*/) override { }
   void SetThreadId(std::thread::id /*id*/) override { }
+  void SetPriority(Priority /*priority*/) override { }
 
-  MulticastDelegate<Ret, Args...>& operator+=(const Delegate<Ret, Args...>& d) {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    m_core.handlers.push_back(d);
-    return *this;
+  Connection operator+=(const Delegate<Ret, Args...>& d) {
+    return Connect(Delegate<Ret, Args...>(d));
   }
 
-  MulticastDelegate<Ret, Args...>& operator+=(Delegate<Ret, Args...>&& d) {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    m_core.handlers.push_back(std::move(d));
-    return *this;
+  Connection operator+=(Delegate<Ret, Args...>&& d) {
+    return Connect(std::move(d));
   }
 
+  // Removes the handler added by the += that returned connection, in O(1).
+  // Returns false if it was removed already.
+  bool Disconnect(const Connection& connection) {
+    std::lock_guard<std::mutex> g(m_core.writeMutex);
+    if (!m_core.handlers.Erase(connection)) {
+      return false;
+    }
+    Unlink(connection.index);
+    m_core.version.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  // Removes the earliest added handler equal to d, in O(1) on average,
+  // also when there are several of them.
   MulticastDelegate<Ret, Args...>& operator-=(const Delegate<Ret, Args...>& d) {
-    std::lock_guard<Mutex> g(m_core.coreMutex);
-    auto it = m_core.find(d);
-    if (it != m_core.handlers.end()) {
-      m_core.handlers.erase(it);
+    std::lock_guard<std::mutex> g(m_core.writeMutex);
+    const auto bucket = m_core.index.find(d.Hash());
+    if (bucket == m_core.index.end()) {
+      return *this;
+    }
+    for (std::uint32_t i = bucket->second.head; i != Core::kNoLink;
+         i = m_core.links[i].next) {
+      if (m_core.handlers.EraseIf(m_core.links[i].connection,
+                                  [&d](const Delegate<Ret, Args...>& handler) {
+                                    return handler == d;
+                                  })) {
+        Unlink(i);
+        m_core.version.fetch_add(1, std::memory_order_release);
+        break;
+      }
     }
     return *this;
   }
 
  private:
-  MulticastDelegateCore<Ret, Args...> m_core;
+  using Core = MulticastDelegateCore<Ret, Args...>;
+
+  Core m_core;
 
   using Type = MulticastDelegate<Ret, Args...>;
   using Mutex = MulticastDelegateCore<Ret, Args...>::Mutex;
 
+  Connection Connect(Delegate<Ret, Args...>&& d) {
+    const std::size_t hash = d.Hash();
+    std::lock_guard<std::mutex> g(m_core.writeMutex);
+    const Connection connection = m_core.handlers.Insert(std::move(d));
+    if (connection.index >= m_core.links.size()) {
+      m_core.links.resize(connection.index + 1);
+    }
+    auto [bucket, added] = m_core.index.try_emplace(
+        hash, typename Core::Bucket{Core::kNoLink, Core::kNoLink});
+    m_core.links[connection.index] = typename Core::Link{
+        connection, hash, bucket->second.tail, Core::kNoLink};
+    if (added) {
+      bucket->second.head = connection.index;
+    } else {
+      m_core.links[bucket->second.tail].next = connection.index;
+    }
+    bucket->second.tail = connection.index;
+    m_core.version.fetch_add(1, std::memory_order_release);
+    return connection;
+  }
+
+  // Must be called with executorMutex held. The version is read before
+  // the handlers, so a plan never outlives a change it missed.
+  std::shared_ptr<const FanOutPlan> CurrentPlan()
+    requires std::is_void_v<Ret>
+  {
+    const std::uint64_t version =
+        m_core.version.load(std::memory_order_acquire);
+    const std::thread::id thread = std::this_thread::get_id();
+    if (m_core.plan != nullptr && m_core.plan_version == version &&
+        m_core.plan_thread == thread) {
+      return m_core.plan;
+    }
+    auto plan = std::make_shared<FanOutPlan>();
+    const auto handlers = m_core.handlers.Read();
+    for (std::size_t i = 0; i < handlers.Size(); ++i) {
+      if (handlers.IsAlive(i)) {
+        m_core.executor.AddToPlan(*plan, handlers[i]);
+      }
+    }
+    m_core.plan = plan;
+    m_core.plan_version = version;
+    m_core.plan_thread = thread;
+    return plan;
+  }
+
+  // Takes the handler at index out of its bucket.
+  void Unlink(std::uint32_t index) {
+    const typename Core::Link& link = m_core.links[index];
+    const auto bucket = m_core.index.find(link.hash);
+    if (link.prev != Core::kNoLink) {
+      m_core.links[link.prev].next = link.next;
+    } else {
+      bucket->second.head = link.next;
+    }
+    if (link.next != Core::kNoLink) {
+      m_core.links[link.next].prev = link.prev;
+    } else {
+      bucket->second.tail = link.prev;
+    }
+    if (bucket->second.head == Core::kNoLink) {
+      m_core.index.erase(bucket);
+    }
+  }
+
+  Ret Execute(const Delegate<Ret, Args...>& d, Args&&... args) {
+    std::lock_guard<Mutex> g(m_core.executorMutex);
+    return m_core.executor.Execute(d, std::forward<Args>(args)...);
+  }
+
  protected:
+  const void* Kind() const override { return utils::TypeTag<Type>(); }
+
   bool Equals(const IDelegate<Ret, Args...>& other) const override {
-    const Type* other_casted = dynamic_cast<const Type*>(&other);
-    if (other_casted == nullptr) {
-      return false;
-    }
-    std::scoped_lock<Mutex, Mutex> lck{m_core.coreMutex, other_casted->m_core.coreMutex};
-    return m_core.handlers == other_casted->m_core.handlers;
+    return m_core.handlers.LiveValues() ==
+           static_cast<const Type&>(other).m_core.handlers.LiveValues();
   }
 };
 
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "event.hpp"
+
+namespace eh {
+
+namespace events {
+
+template <typename Signature, auto... Handlers>
+class StaticEvent;
+
+// Event whose handlers are known at compile time, e.g.
+//
+//   StaticEvent<void(int), &OnTick, &Statistics::Count> tick;
+//
+// Handlers are functions, static member functions or captureless lambdas.
+// Triggering calls them in order on the triggering thread, directly and
+// without locking or allocating, so the compiler can inline them; their
+// results are discarded. Handlers added at runtime go to an Event that is
+// only created on first use and are triggered after the static ones with
+// the usual Event semantics.
+template <typename... Args, auto... Handlers>
+class StaticEvent<void(Args...), Handlers...> final : public IEvent<Args...> {
+  static_assert((std::is_invocable_v<decltype(Handlers), Args...> && ...),
+                "every handler must be callable with the event arguments");
+
+ public:
+  StaticEvent() = default;
+  ~StaticEvent() override { delete m_runtime.load(); }
+
+  static constexpr std::size_t kStaticHandlers = sizeof...(Handlers);
+
+  bool HasHandlers() const override {
+    return kStaticHandlers > 0 || RuntimeWithHandlers() != nullptr;
+  }
+
+  delegates::Connection AddHandler(
+      const EventHandler<Args...>& handler) override {
+    return Runtime().AddHandler(handler);
+  }
+  bool RemoveHandler(const delegates::Connection& connection) override {
+    Event<Args...>* runtime = m_runtime.load(std::memory_order_acquire);
+    return runtime != nullptr && runtime->RemoveHandler(connection);
+  }
+  void RemoveHandler(const EventHandler<Args...>& handler) override {
+    if (Event<Args...>* runtime = m_runtime.load(std::memory_order_acquire)) {
+      runtime->RemoveHandler(handler);
+    }
+  }
+
+  void SyncTrigger(Args&&... args) override {
+    InvokeStatic(std::forward<Args>(args)...);
+    if (Event<Args...>* runtime = RuntimeWithHandlers()) {
+      runtime->SyncTrigger(std::forward<Args>(args)...);
+    }
+  }
+
+  // Static handlers have no thread of their own and run synchronously;
+  // runtime handlers are queued to their threads as Event does.
+  utils::EnqueueStatus AsyncTrigger(Args&&... args) override {
+    InvokeStatic(std::forward<Args>(args)...);
+    if (Event<Args...>* runtime = RuntimeWithHandlers()) {
+      return runtime->AsyncTrigger(std::forward<Args>(args)...);
+    }
+    return utils::EnqueueStatus::Accepted;
+  }
+  utils::EnqueueStatus ConflatingTrigger(Args&&... args) override {
+    InvokeStatic(std::forward<Args>(args)...);
+    if (Event<Args...>* runtime = RuntimeWithHandlers()) {
+      return runtime->ConflatingTrigger(std::forward<Args>(args)...);
+    }
+    return utils::EnqueueStatus::Accepted;
+  }
+
+  TriggerType GetTriggerType() const override { return m_trigger_type; }
+  void SetTriggerType(TriggerType trigger_type) override {
+    m_trigger_type = trigger_type;
+  }
+
+ private:
+  StaticEvent(const StaticEvent&) = delete;
+  StaticEvent& operator=(const StaticEvent&) = delete;
+
+  static void InvokeStatic(Args&&... args) {
+    (static_cast<void>(std::invoke(Handlers, std::forward<Args>(args)...)),
+     ...);
+  }
+
+  Event<Args...>* RuntimeWithHandlers() const {
+    Event<Args...>* runtime = m_runtime.load(std::memory_order_acquire);
+    return runtime != nullptr && runtime->HasHandlers() ? runtime : nullptr;
+  }
+
+  Event<Args...>& Runtime() {
+    Event<Args...>* runtime = m_runtime.load(std::memory_order_acquire);
+    if (runtime != nullptr) {
+      return *runtime;
+    }
+    auto created = std::make_unique<Event<Args...>>();
+    if (m_runtime.compare_exchange_strong(runtime, created.get(),
+                                          std::memory_order_acq_rel)) {
+      return *created.release();
+    }
+    return *runtime;
+  }
+
+  std::atomic<TriggerType> m_trigger_type{TriggerType::Synchronous};
+  std::atomic<Event<Args...>*> m_runtime{nullptr};
+};
+
+}  // namespace events
+
+}  // namespace eh
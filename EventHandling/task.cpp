@@ -26,12 +26,12 @@ void Task::Cancel() { m_state = TaskState::Cancelled; }
 
 void Task::DoWork() {
   std::lock_guard<std::recursive_mutex> g(m_mutex);
-  if (!m_callback_queue->empty()) {
-    auto current = m_callback_queue->Get();
-    if (current != nullptr) {
-      current->Perform();
-    }
+  m_callback_queue->Drain(m_batch, utils::ICallbackQueue::kDrainAll);
+  for (auto& current : m_batch) {
+    current->Perform();
+    current.reset();
   }
+  m_batch.clear();
 }
 
 void eh::Task::RegisterCallbackQueue(const utils::ICallbackQueuePtr& callback) {
@@ -31,6 +31,7 @@ class Task {
   std::atomic<TaskState> m_state;
   std::recursive_mutex m_mutex;
   utils::ICallbackQueuePtr m_callback_queue;
+  utils::ICallbackQueue::Batch m_batch;
   std::vector<utils::ICallbackQueuePtr> m_callback_queues;
   std::weak_ptr<Thread> m_thread;
 };
@@ -1,6 +1,12 @@
 #include "thread.hpp"
+#include "delegate.hpp"
 #include "event_system.h"
+#include "thread_placement.h"
 #include "utils/callback_queue.hpp"
+#include "utils/helper.hpp"
+#include "utils/priority_callback_queue.hpp"
+#include "utils/ring_callback_queue.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace eh {
@@ -13,29 +19,69 @@ namespace eh {
 //  mutable std::recursive_mutex m_mutex;
 //};
 
-Thread::ThreadData::ThreadData()
-    : m_queue(std::make_shared<utils::CallBackQueue>()), m_is_running(false) {}
+namespace {
 
-Thread::Thread() : m_data(std::make_unique<Thread::ThreadData>()) {}
+thread_local Thread* current_thread = nullptr;
 
-ThreadPtr Thread::Create() {
-  return std::shared_ptr<Thread>(new Thread());
+utils::ICallbackQueuePtr CreateCallbackQueue(const ThreadOptions& options) {
+  const ScopedNumaAllocation on_node(options.numa_node);
+  switch (options.queue_type) {
+    case CallbackQueueType::Ring:
+      return std::make_shared<utils::RingCallbackQueue>(
+          options.queue_capacity != 0
+              ? options.queue_capacity
+              : utils::RingCallbackQueue::kDefaultCapacity,
+          options.overflow_policy);
+    case CallbackQueueType::Priority:
+      return std::make_shared<utils::PriorityCallbackQueue>(
+          options.queue_capacity, options.overflow_policy,
+          options.starvation_limit);
+    case CallbackQueueType::List:
+      break;
+  }
+  return std::make_shared<utils::CallBackQueue>(options.queue_capacity,
+                                                options.overflow_policy);
 }
 
-ThreadPtr Thread::CreateRegistered() {
-  auto th = Thread::Create();
+}  // namespace
+
+Thread::ThreadData::ThreadData(const ThreadOptions& options)
+    : m_options(options),
+      m_queue(CreateCallbackQueue(options)),
+      m_timers(std::chrono::duration_cast<Clock::duration>(
+          options.timer_resolution)),
+      m_sleep_until(Clock::time_point::max().time_since_epoch().count()),
+      m_is_running(false) {
+  m_batch.reserve(std::min<std::size_t>(options.batch_size, 1024));
+}
+
+Thread::Thread(const ThreadOptions& options)
+    : m_data(std::make_unique<Thread::ThreadData>(options)) {}
+
+ThreadPtr Thread::Create(const ThreadOptions& options) {
+  return std::shared_ptr<Thread>(new Thread(options));
+}
+
+ThreadPtr Thread::CreateRegistered(const ThreadOptions& options) {
+  auto th = Thread::Create(options);
   th->Start();
   EventSystem::Instance().RegisterThread(th);
   return th;
 }
 
  std::optional<ThreadPtr> Thread::FindRegistered(std::thread::id id) {
-  if (EventSystem::Instance().ContainsRegistererdThread(id)) {
-    return EventSystem::Instance().GetRegisteredThread(id);
+  if (!EventSystem::IsInitialized()) {
+    return std::nullopt;
   }
-  return std::nullopt;
+  return EventSystem::Instance().FindRegisteredThread(id);
  }
 
+ThreadPtr Thread::Current() {
+  // Null while the last owner is destroying the thread and waits for it.
+  return current_thread != nullptr ? current_thread->weak_from_this().lock()
+                                   : nullptr;
+}
+
 Thread::~Thread() {
   std::lock_guard<std::recursive_mutex> g(m_data->m_mutex);
   if (IsRunning()) {
@@ -51,7 +97,19 @@ void Thread::Start() {
   std::lock_guard<std::recursive_mutex> g(m_data->m_mutex);
   if (!IsRunning()) {
     m_data->m_is_running = true;
-    m_thread = std::make_unique<std::thread>(&Thread::ThreadFunc, this);
+    m_data->m_queue->Open();
+    std::promise<void> placed;
+    std::future<void> placement = placed.get_future();
+    m_thread = std::make_unique<std::thread>(&Thread::ThreadFunc, this,
+                                             std::move(placed));
+    try {
+      placement.get();
+    } catch (...) {
+      m_data->m_is_running = false;
+      m_thread->join();
+      m_thread.reset();
+      throw;
+    }
   }
 }
 
@@ -59,13 +117,18 @@ void Thread::Stop() {
   std::lock_guard<std::recursive_mutex> g(m_data->m_mutex);
   if (IsRunning()) {
     m_data->m_is_running = false;
+    m_data->m_queue->Wake();
   }
+  // Nobody frees room in the queue any more.
+  m_data->m_queue->Close();
   if (m_thread != nullptr && m_thread->joinable()) {
     m_thread->join();
   }
   m_thread.reset();
 }
 
+bool Thread::IsCurrent() const noexcept { return current_thread == this; }
+
 bool Thread::IsRunning() const {
   std::lock_guard<std::recursive_mutex> g(m_data->m_mutex);
   return m_data->m_is_running && m_thread != nullptr;
@@ -84,19 +147,130 @@ const utils::ICallbackQueuePtr& Thread::CallbackQueue() const {
   return m_data->m_queue;
 }
 
-void Thread::ThreadFunc() {
-  while (m_data->m_is_running) {
-    ProcessQueue();
+const ThreadOptions& Thread::Options() const { return m_data->m_options; }
+
+ThreadMetrics Thread::Metrics() const {
+  const utils::ICallbackQueue& queue = *m_data->m_queue;
+  ThreadMetrics metrics;
+  metrics.dropped = queue.DroppedCount();
+#ifdef EH_ENABLE_METRICS
+  metrics.enqueued = queue.EnqueuedCount();
+  metrics.executed = m_data->m_metrics.Executed();
+  metrics.depth = queue.Depth();
+  metrics.high_water = queue.HighWaterMark();
+  metrics.queue_wait = m_data->m_metrics.QueueWait().Snapshot();
+  metrics.execution = m_data->m_metrics.Execution().Snapshot();
+#endif  // EH_ENABLE_METRICS
+  return metrics;
+}
+
+Thread::TimerId Thread::PostAfter(Clock::duration delay,
+                                  const delegates::Delegate<void>& callback) {
+  return Schedule(delay, Clock::duration::zero(), callback);
+}
+
+Thread::TimerId Thread::PostEvery(Clock::duration period,
+                                  const delegates::Delegate<void>& callback) {
+  return Schedule(period, period, callback);
+}
+
+bool Thread::CancelTimer(const TimerId& id) {
+  return m_data->m_timers.Cancel(id);
+}
+
+Thread::TimerId Thread::Schedule(Clock::duration delay, Clock::duration period,
+                                 const delegates::Delegate<void>& callback) {
+  if (callback.IsEmpty()) {
+    throw delegates::DelegateException("Callable object is empty");
   }
+  const Clock::time_point deadline = Clock::now() + delay;
+  TimerId id = m_data->m_timers.Schedule(deadline, period, callback.m_invocable);
+  // A parked thread only wakes up for the deadline it computed before.
+  if (deadline.time_since_epoch().count() < m_data->m_sleep_until.load()) {
+    m_data->m_queue->Wake();
+  }
+  return id;
 }
 
-void Thread::ProcessQueue() {
-  if (!m_data->m_queue->empty()) {
-    auto current = m_data->m_queue->Get();
-    if (current != nullptr) {
-      current->Perform();
+void Thread::ThreadFunc(std::promise<void> placed) {
+  try {
+    ApplyThreadPlacement(m_data->m_options);
+  } catch (...) {
+    placed.set_exception(std::current_exception());
+    return;
+  }
+  placed.set_value();
+  current_thread = this;
+  std::size_t idle_rounds = 0;
+  while (m_data->m_is_running) {
+    const bool processed = ProcessQueue();
+    if (ProcessTimers() || processed) {
+      idle_rounds = 0;
+    } else {
+      Idle(idle_rounds++);
     }
   }
+  current_thread = nullptr;
+}
+
+bool Thread::ProcessQueue() {
+  auto& batch = m_data->m_batch;
+  if (m_data->m_queue->Drain(batch, m_data->m_options.batch_size) == 0) {
+    return false;
+  }
+  for (auto& current : batch) {
+#if defined(EH_ENABLE_METRICS) || defined(EH_ENABLE_TRACING)
+    // A call may requeue itself from Perform(), which restamps it.
+#ifdef EH_ENABLE_METRICS
+    const Clock::time_point enqueued = current->EnqueueTime();
+#endif  // EH_ENABLE_METRICS
+#ifdef EH_ENABLE_TRACING
+    const std::uint64_t flow = current->TraceFlow();
+#endif  // EH_ENABLE_TRACING
+    const Clock::time_point started = Clock::now();
+    current->Perform();
+    const Clock::time_point finished = Clock::now();
+#ifdef EH_ENABLE_METRICS
+    m_data->m_metrics.OnExecuted(started - enqueued, finished - started);
+#endif  // EH_ENABLE_METRICS
+#ifdef EH_ENABLE_TRACING
+    utils::Tracer::RecordExecute(flow, started, finished);
+#endif  // EH_ENABLE_TRACING
+#else
+    current->Perform();
+#endif
+    current.reset();
+  }
+  batch.clear();
+  return true;
+}
+
+bool Thread::ProcessTimers() {
+  auto& timers = m_data->m_timers;
+  return !timers.Empty() && timers.Advance(Clock::now()) != 0;
+}
+
+void Thread::Idle(std::size_t idle_rounds) {
+  const ThreadOptions& options = m_data->m_options;
+  if (options.idle_strategy == IdleStrategy::Spin ||
+      idle_rounds < options.spin_count) {
+    utils::CpuRelax();
+    return;
+  }
+  if (options.idle_strategy == IdleStrategy::SpinYield) {
+    std::this_thread::yield();
+    return;
+  }
+  // Publish the deadline before checking it again, so a timer scheduled
+  // meanwhile either shows up here or wakes the queue.
+  auto& timers = m_data->m_timers;
+  const Clock::time_point deadline = timers.NextDeadline();
+  m_data->m_sleep_until.store(deadline.time_since_epoch().count());
+  if (timers.NextDeadline() >= deadline) {
+    m_data->m_queue->WaitForCallback(deadline);
+  }
+  m_data->m_sleep_until.store(
+      Clock::time_point::max().time_since_epoch().count());
 }
 
 }  // namespace eh
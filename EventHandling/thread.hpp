@@ -7,41 +7,90 @@
 #include <atomic>
 #include <optional>
 
+#include "thread_options.h"
 #include "utils/callback_queue_base.hpp"
+#include "utils/metrics.hpp"
+#include "utils/timer_wheel.hpp"
 
 namespace eh {
 
+namespace delegates {
+
+template <typename Ret, typename... Args>
+class Delegate;
+
+}  // namespace delegates
+
 class Thread : public std::enable_shared_from_this<Thread> {
  public:
   using Ptr = std::shared_ptr<Thread>;
   using WPtr = std::shared_ptr<Thread>;
+  using Clock = utils::TimerWheel::Clock;
+  using TimerId = utils::TimerWheel::TimerId;
 
-  static Ptr Create();
-  static Ptr CreateRegistered();
+  static Ptr Create(const ThreadOptions& options = {});
+  static Ptr CreateRegistered(const ThreadOptions& options = {});
   static std::optional<Ptr> FindRegistered(std::thread::id id);
+  // The eh::Thread the caller runs on, nullptr outside of them. Read from a
+  // thread_local, so unlike FindRegistered it never touches the registry and
+  // also finds threads that are not registered.
+  static Ptr Current();
 
   ~Thread();
 
+  // Launches the OS thread and applies the placement of Options() to it.
+  // Throws std::system_error and stays stopped if that fails.
   void Start();
   void Stop();
   bool IsRunning() const;
   std::thread::id ThreadId() const;
+  // Whether the caller runs on this thread. Lock-free, unlike ThreadId.
+  bool IsCurrent() const noexcept;
   const utils::ICallbackQueuePtr& CallbackQueue() const;
+  const ThreadOptions& Options() const;
+  // Counters and latency histograms of this thread and its queue. Only
+  // `dropped` is filled in unless built with EH_ENABLE_METRICS.
+  ThreadMetrics Metrics() const;
+
+  // Runs callback on this thread once delay has passed, directly and
+  // regardless of its invoke type. Safe to call from any thread; timers of
+  // a stopped thread do not fire until it is started again.
+  TimerId PostAfter(Clock::duration delay,
+                    const delegates::Delegate<void>& callback);
+  // Same, every period starting one period from now. Periods missed while
+  // the thread was busy are skipped.
+  TimerId PostEvery(Clock::duration period,
+                    const delegates::Delegate<void>& callback);
+  // O(1). Returns false if the timer fired already or was cancelled.
+  bool CancelTimer(const TimerId& id);
 
  private:
-  Thread();
+  explicit Thread(const ThreadOptions& options);
   Thread(const Thread& other) = delete;
   Thread(Thread&& other) = delete;
-  void ThreadFunc();
-  void ProcessQueue();
+  void ThreadFunc(std::promise<void> placed);
+  bool ProcessQueue();
+  bool ProcessTimers();
+  void Idle(std::size_t idle_rounds);
+  TimerId Schedule(Clock::duration delay, Clock::duration period,
+                   const delegates::Delegate<void>& callback);
 
   //struct ThreadData;
   struct ThreadData {
-    ThreadData();
+    explicit ThreadData(const ThreadOptions& options);
 
+    ThreadOptions m_options;
     std::shared_ptr<utils::ICallbackQueue> m_queue;
+    utils::ICallbackQueue::Batch m_batch;
+    utils::TimerWheel m_timers;
+    // Deadline the parked thread waits for, Clock::time_point::max() while
+    // it does not park.
+    std::atomic<Clock::rep> m_sleep_until;
     std::atomic_bool m_is_running;
     mutable std::recursive_mutex m_mutex;
+#ifdef EH_ENABLE_METRICS
+    utils::ExecutionCounters m_metrics;
+#endif  // EH_ENABLE_METRICS
   };
 
   std::unique_ptr<std::thread> m_thread;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "utils/overflow_policy.hpp"
+
+namespace eh {
+
+// What an eh::Thread does when its callback queue is empty.
+enum class IdleStrategy {
+  // Keeps polling the queue. Lowest wake-up latency, burns a whole core.
+  Spin,
+  // Polls spin_count times, then yields the core on every idle round.
+  SpinYield,
+  // Polls spin_count times, then parks until a callback is added.
+  SpinPark
+};
+
+// Implementation backing Thread::CallbackQueue().
+enum class CallbackQueueType {
+  // Intrusive FIFO behind a mutex, unbounded unless queue_capacity is set.
+  List,
+  // Bounded lock-free MPSC ring, see utils::RingCallbackQueue.
+  Ring,
+  // Serves callbacks by priority, see utils::PriorityCallbackQueue.
+  Priority
+};
+
+// Linux scheduling policy of an eh::Thread.
+enum class SchedulingPolicy {
+  // SCHED_OTHER, weighted by ThreadOptions::nice.
+  Other,
+  // Real-time SCHED_FIFO and SCHED_RR at ThreadOptions::realtime_priority.
+  // Usually need CAP_SYS_NICE or an RLIMIT_RTPRIO.
+  Fifo,
+  RoundRobin
+};
+
+struct ThreadOptions {
+  IdleStrategy idle_strategy{IdleStrategy::SpinPark};
+  // Number of empty polls before the thread yields or parks.
+  std::size_t spin_count{1024};
+  // Maximum number of callbacks taken from the queue in one step.
+  std::size_t batch_size{64};
+
+  CallbackQueueType queue_type{CallbackQueueType::List};
+  // Maximum number of pending callbacks, 0 picks the queue's default. The
+  // ring queue rounds it up to a power of two.
+  std::size_t queue_capacity{0};
+  // Applied when a producer finds a bounded queue full.
+  utils::OverflowPolicy overflow_policy{utils::OverflowPolicy::Block};
+  // Times a pending priority level may be passed over before it is served.
+  std::size_t starvation_limit{32};
+
+  // Tick of the timer wheel behind Thread::PostAfter and PostEvery. Timers
+  // fire up to one tick late, never early.
+  std::chrono::nanoseconds timer_resolution{std::chrono::milliseconds(1)};
+
+  // Placement of the OS thread, applied by the thread itself when
+  // Thread::Start launches it. Only supported on Linux and ignored
+  // elsewhere. Start throws std::system_error if any of it is refused.
+  //
+  // CPUs the thread may run on, any if empty.
+  std::vector<std::size_t> cpu_affinity;
+  // NUMA node the thread runs on and preferably allocates memory from,
+  // narrowing cpu_affinity down to the CPUs of the node. The callback
+  // queue is allocated there as well.
+  std::optional<int> numa_node;
+  SchedulingPolicy scheduling_policy{SchedulingPolicy::Other};
+  // 1 (lowest) to 99, only used by the real-time policies.
+  int realtime_priority{1};
+  // Nice level under SchedulingPolicy::Other, inherited if not set.
+  std::optional<int> nice;
+  // Name shown by top, gdb and perf, truncated to 15 characters.
+  std::string name;
+};
+
+}  // namespace eh
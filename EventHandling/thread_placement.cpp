@@ -0,0 +1,185 @@
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace eh {
+
+namespace {
+
+[[noreturn]] void ThrowSystemError(int error, const char* what) {
+  throw std::system_error(error, std::system_category(), what);
+}
+
+#ifdef __linux__
+
+// Bits of the node masks passed to the kernel, enough for any machine.
+constexpr unsigned long kMaxNodes = 1024;
+constexpr std::size_t kMaskWords = kMaxNodes / (8 * sizeof(unsigned long));
+
+std::vector<unsigned long> NodeMask(int node) {
+  if (node < 0 || static_cast<unsigned long>(node) >= kMaxNodes - 1) {
+    ThrowSystemError(EINVAL, "NUMA node out of range");
+  }
+  std::vector<unsigned long> mask(kMaskWords, 0);
+  const auto bit = static_cast<std::size_t>(node);
+  mask[bit / (8 * sizeof(unsigned long))] |=
+      1ul << (bit % (8 * sizeof(unsigned long)));
+  return mask;
+}
+
+// glibc only wraps these in libnuma.
+long GetMempolicy(int* mode, unsigned long* nodes) {
+  return syscall(SYS_get_mempolicy, mode, nodes, kMaxNodes, nullptr, 0);
+}
+
+long SetMempolicy(int mode, const unsigned long* nodes) {
+  return syscall(SYS_set_mempolicy, mode, nodes, kMaxNodes);
+}
+
+void SetAffinity(const std::vector<std::size_t>& cpus) {
+  const std::size_t count = *std::max_element(cpus.begin(), cpus.end()) + 1;
+  cpu_set_t* set = CPU_ALLOC(count);
+  if (set == nullptr) {
+    ThrowSystemError(ENOMEM, "CPU_ALLOC");
+  }
+  const std::size_t size = CPU_ALLOC_SIZE(count);
+  CPU_ZERO_S(size, set);
+  for (std::size_t cpu : cpus) {
+    CPU_SET_S(cpu, size, set);
+  }
+  const int error = pthread_setaffinity_np(pthread_self(), size, set);
+  CPU_FREE(set);
+  if (error != 0) {
+    ThrowSystemError(error, "pthread_setaffinity_np");
+  }
+}
+
+#endif  // __linux__
+
+}  // namespace
+
+std::vector<std::size_t> NumaNodeCpus([[maybe_unused]] int node) {
+  std::vector<std::size_t> cpus;
+#ifdef __linux__
+  // A cpulist looks like "0-3,8-11".
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist");
+  std::string range;
+  while (std::getline(file, range, ',')) {
+    std::istringstream in(range);
+    std::size_t first = 0;
+    std::size_t last = 0;
+    if (!(in >> first)) {
+      continue;
+    }
+    last = first;
+    if (in.get() == '-') {
+      in >> last;
+    }
+    for (std::size_t cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+#endif  // __linux__
+  return cpus;
+}
+
+void ApplyThreadPlacement([[maybe_unused]] const ThreadOptions& options) {
+#ifdef __linux__
+  if (!options.name.empty()) {
+    const int error =
+        pthread_setname_np(pthread_self(), options.name.substr(0, 15).c_str());
+    if (error != 0) {
+      ThrowSystemError(error, "pthread_setname_np");
+    }
+  }
+
+  std::vector<std::size_t> cpus = options.cpu_affinity;
+  if (options.numa_node.has_value()) {
+    const std::vector<std::size_t> node_cpus =
+        NumaNodeCpus(*options.numa_node);
+    if (node_cpus.empty()) {
+      ThrowSystemError(ENODEV, "NUMA node has no CPUs");
+    }
+    if (cpus.empty()) {
+      cpus = node_cpus;
+    } else {
+      std::erase_if(cpus, [&node_cpus](std::size_t cpu) {
+        return std::find(node_cpus.begin(), node_cpus.end(), cpu) ==
+               node_cpus.end();
+      });
+      if (cpus.empty()) {
+        ThrowSystemError(EINVAL, "cpu_affinity has no CPU of the NUMA node");
+      }
+    }
+    const std::vector<unsigned long> nodes = NodeMask(*options.numa_node);
+    if (SetMempolicy(MPOL_PREFERRED, nodes.data()) != 0) {
+      ThrowSystemError(errno, "set_mempolicy");
+    }
+  }
+  if (!cpus.empty()) {
+    SetAffinity(cpus);
+  }
+
+  if (options.scheduling_policy != SchedulingPolicy::Other) {
+    sched_param param{};
+    param.sched_priority = options.realtime_priority;
+    const int error = pthread_setschedparam(
+        pthread_self(),
+        options.scheduling_policy == SchedulingPolicy::Fifo ? SCHED_FIFO
+                                                            : SCHED_RR,
+        &param);
+    if (error != 0) {
+      ThrowSystemError(error, "pthread_setschedparam");
+    }
+  } else if (options.nice.has_value()) {
+    // On Linux the nice level belongs to the thread, not the process.
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, *options.nice) != 0) {
+      ThrowSystemError(errno, "setpriority");
+    }
+  }
+#endif  // __linux__
+}
+
+ScopedNumaAllocation::ScopedNumaAllocation(
+    [[maybe_unused]] std::optional<int> node) {
+#ifdef __linux__
+  if (!node.has_value()) {
+    return;
+  }
+  const std::vector<unsigned long> nodes = NodeMask(*node);
+  m_previous_nodes.assign(kMaskWords, 0);
+  if (GetMempolicy(&m_previous_mode, m_previous_nodes.data()) != 0) {
+    ThrowSystemError(errno, "get_mempolicy");
+  }
+  if (SetMempolicy(MPOL_PREFERRED, nodes.data()) != 0) {
+    ThrowSystemError(errno, "set_mempolicy");
+  }
+  m_active = true;
+#endif  // __linux__
+}
+
+ScopedNumaAllocation::~ScopedNumaAllocation() {
+#ifdef __linux__
+  if (m_active) {
+    SetMempolicy(m_previous_mode, m_previous_nodes.data());
+  }
+#endif  // __linux__
+}
+
+}  // namespace eh
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "thread_options.h"
+
+namespace eh {
+
+// CPUs of a NUMA node as listed by sysfs, empty if there is no such node or
+// the platform has no NUMA support.
+std::vector<std::size_t> NumaNodeCpus(int node);
+
+// Applies the placement part of options, cpu_affinity through name, to the
+// calling thread. Throws std::system_error for the first setting refused.
+// Does nothing but on Linux.
+void ApplyThreadPlacement(const ThreadOptions& options);
+
+// Makes the calling thread prefer memory of node for pages it faults in
+// during its lifetime, restoring the previous policy afterwards. Memory the
+// allocator recycles keeps the node it was first placed on. No-op without
+// a node or outside Linux.
+class ScopedNumaAllocation {
+ public:
+  explicit ScopedNumaAllocation(std::optional<int> node);
+  ~ScopedNumaAllocation();
+
+  ScopedNumaAllocation(const ScopedNumaAllocation&) = delete;
+  ScopedNumaAllocation& operator=(const ScopedNumaAllocation&) = delete;
+
+ private:
+  bool m_active{false};
+  int m_previous_mode{0};
+  std::vector<unsigned long> m_previous_nodes;
+};
+
+}  // namespace eh
@@ -0,0 +1,182 @@
+#include "call_pool.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "helper.hpp"
+
+namespace eh {
+
+namespace utils {
+
+namespace {
+
+constexpr std::size_t kHeaderSize = CallPool::kAlignment;
+constexpr std::array<std::size_t, 5> kBlockSizes = {64, 128, 256, 512, 1024};
+constexpr std::size_t kSizeClasses = kBlockSizes.size();
+constexpr std::size_t kLargeBlock = kSizeClasses;
+constexpr std::size_t kSlabSize = 16 * 1024;
+
+class LocalPool;
+
+// Precedes every block handed out; never changes once the block is carved.
+struct alignas(kHeaderSize) BlockHeader {
+  LocalPool* owner;
+  std::size_t size_class;
+};
+
+static_assert(sizeof(BlockHeader) == kHeaderSize);
+static_assert(kBlockSizes.back() - kHeaderSize == CallPool::kMaxSize);
+
+// Stored in the payload of a free block.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+FreeBlock* ToFreeBlock(BlockHeader* header) {
+  return reinterpret_cast<FreeBlock*>(header + 1);
+}
+
+BlockHeader* ToHeader(void* payload) {
+  return static_cast<BlockHeader*>(payload) - 1;
+}
+
+std::size_t SizeClassOf(std::size_t size) {
+  for (std::size_t size_class = 0; size_class < kSizeClasses; ++size_class) {
+    if (size + kHeaderSize <= kBlockSizes[size_class]) {
+      return size_class;
+    }
+  }
+  return kLargeBlock;
+}
+
+class LocalPool {
+ public:
+  void* Allocate(std::size_t size_class) {
+    FreeBlock*& head = m_free[size_class];
+    if (head == nullptr) {
+      head = m_returned[size_class].value.exchange(nullptr,
+                                                   std::memory_order_acquire);
+    }
+    if (head == nullptr) {
+      Refill(size_class);
+    }
+    FreeBlock* block = head;
+    head = block->next;
+    return block;
+  }
+
+  // Only the owning thread may call this.
+  void Free(FreeBlock* block, std::size_t size_class) noexcept {
+    block->next = m_free[size_class];
+    m_free[size_class] = block;
+  }
+
+  void Return(FreeBlock* block, std::size_t size_class) noexcept {
+    auto& returned = m_returned[size_class].value;
+    FreeBlock* head = returned.load(std::memory_order_relaxed);
+    do {
+      block->next = head;
+    } while (!returned.compare_exchange_weak(
+        head, block, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+ private:
+  struct alignas(kCacheLineSize) ReturnStack {
+    std::atomic<FreeBlock*> value{nullptr};
+  };
+
+  void Refill(std::size_t size_class) {
+    const std::size_t block_size = kBlockSizes[size_class];
+    auto* slab = static_cast<char*>(::operator new(kSlabSize));
+    for (std::size_t offset = 0; offset + block_size <= kSlabSize;
+         offset += block_size) {
+      auto* header = ::new (slab + offset) BlockHeader{this, size_class};
+      Free(ToFreeBlock(header), size_class);
+    }
+  }
+
+  std::array<FreeBlock*, kSizeClasses> m_free{};
+  std::array<ReturnStack, kSizeClasses> m_returned;
+};
+
+// Pools are never destroyed: blocks of a finished thread may still be in
+// flight, so its pool waits here for the next thread that needs one.
+class OrphanPools {
+ public:
+  static OrphanPools& Instance() {
+    static OrphanPools* instance = new OrphanPools();
+    return *instance;
+  }
+
+  LocalPool* Adopt() {
+    {
+      std::lock_guard<std::mutex> g(m_mutex);
+      if (!m_pools.empty()) {
+        LocalPool* pool = m_pools.back();
+        m_pools.pop_back();
+        return pool;
+      }
+    }
+    return new LocalPool();
+  }
+
+  void Release(LocalPool* pool) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_pools.push_back(pool);
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::vector<LocalPool*> m_pools;
+};
+
+thread_local LocalPool* current_pool = nullptr;
+
+struct PoolReleaser {
+  ~PoolReleaser() {
+    OrphanPools::Instance().Release(current_pool);
+    current_pool = nullptr;
+  }
+};
+
+LocalPool& CurrentPool() {
+  if (current_pool == nullptr) {
+    thread_local PoolReleaser releaser;
+    current_pool = OrphanPools::Instance().Adopt();
+  }
+  return *current_pool;
+}
+
+}  // namespace
+
+void* CallPool::Allocate(std::size_t size) {
+  const std::size_t size_class = SizeClassOf(size);
+  if (size_class == kLargeBlock) {
+    auto* header = ::new (::operator new(size + kHeaderSize))
+        BlockHeader{nullptr, kLargeBlock};
+    return header + 1;
+  }
+  return CurrentPool().Allocate(size_class);
+}
+
+void CallPool::Deallocate(void* block) noexcept {
+  if (block == nullptr) {
+    return;
+  }
+  BlockHeader* header = ToHeader(block);
+  if (header->owner == nullptr) {
+    ::operator delete(header);
+  } else if (header->owner == current_pool) {
+    header->owner->Free(static_cast<FreeBlock*>(block), header->size_class);
+  } else {
+    header->owner->Return(static_cast<FreeBlock*>(block), header->size_class);
+  }
+}
+
+}  // namespace utils
+
+}  // namespace eh
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace eh {
+
+namespace utils {
+
+// Size-class allocator for wrapped calls.
+//
+// Calls are usually created on one thread and released on another. Every
+// thread allocates from a pool of its own; a block released by a different
+// thread is pushed onto the owning pool's lock-free return stack, which the
+// owner takes over in one exchange once its local free list runs dry.
+// Blocks are never handed back to the system, so once the number of calls in
+// flight stops growing, allocating and releasing a call does not reach the
+// global allocator. Pools of finished threads are adopted by new threads.
+//
+// Requests larger than kMaxSize go straight to ::operator new.
+class CallPool {
+ public:
+  static constexpr std::size_t kAlignment = alignof(std::max_align_t);
+  static constexpr std::size_t kMaxSize = 1024 - kAlignment;
+
+  static void* Allocate(std::size_t size);
+  static void Deallocate(void* block) noexcept;
+};
+
+}  // namespace utils
+
+}  // namespace eh
@@ -1,8 +1,9 @@
 #pragma once
 
-#include <list>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <utility>
 
 #include "callback_queue_base.hpp"
 
@@ -14,17 +15,45 @@ class NoopCallbackQueue : public ICallbackQueue {
  public:
   NoopCallbackQueue() = default;
 
-  void addCallback(const WrappedCallBasePtr& callback) override {
-    std::lock_guard<std::mutex> g(m_mutex);
-    m_callback = callback;
-    //m_callback->Perform();
+  EnqueueStatus addCallback(const WrappedCallBasePtr& callback) override {
+    WrappedCallBasePtr replaced;
+    {
+      std::lock_guard<std::mutex> g(m_mutex);
+      replaced = std::move(m_callback);
+      if (replaced != nullptr) {
+        RecordDequeued(1);
+      }
+      RecordEnqueued(*callback);
+      m_callback = callback;
+      //m_callback->Perform();
+    }
+    NotifyConsumer();
+    if (replaced != nullptr) {
+      RecordOverflow();
+      Drop(replaced);
+      return EnqueueStatus::DroppedOldest;
+    }
+    return EnqueueStatus::Accepted;
   }
 
   WrappedCallBasePtr Get() override {
     std::lock_guard<std::mutex> g(m_mutex);
+    if (m_callback != nullptr) {
+      RecordDequeued(1);
+    }
     return std::move(m_callback);
   }
 
+  std::size_t Drain(Batch& batch, std::size_t max_count) override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    if (m_callback == nullptr || max_count == 0) {
+      return 0;
+    }
+    batch.push_back(std::move(m_callback));
+    RecordDequeued(1);
+    return 1;
+  }
+
   bool empty() const override {
     std::lock_guard<std::mutex> g(m_mutex);
     return m_callback == nullptr;
@@ -37,33 +66,162 @@ class NoopCallbackQueue : public ICallbackQueue {
 
 class CallBackQueue : public ICallbackQueue {
  public:
+  static constexpr std::size_t kUnbounded = 0;
+
   CallBackQueue() = default;
+  explicit CallBackQueue(std::size_t capacity,
+                         OverflowPolicy policy = OverflowPolicy::Block)
+      : m_capacity(capacity), m_policy(policy) {}
+  ~CallBackQueue() override {
+    while (m_head != nullptr) {
+      PopFront();
+    }
+  }
 
-  void addCallback(const WrappedCallBasePtr& callback) override {
-    std::lock_guard<std::mutex> g(m_mutex);
-    m_callbacks.push_back(callback);
+  // Throws std::logic_error if callback waits in a CallBackQueue already.
+  EnqueueStatus addCallback(const WrappedCallBasePtr& callback) override {
+    if (callback->m_linked.exchange(true, std::memory_order_acquire)) {
+      throw std::logic_error("The callback is queued already");
+    }
+    EnqueueStatus status = EnqueueStatus::Accepted;
+    WrappedCallBasePtr oldest;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (IsFull()) {
+        RecordOverflow();
+        switch (m_policy) {
+          case OverflowPolicy::Block:
+            ++m_blocked_producers;
+            m_not_full.wait(lock, [this] { return !IsFull() || IsClosed(); });
+            --m_blocked_producers;
+            if (IsFull()) {
+              status = EnqueueStatus::DroppedNewest;
+            }
+            break;
+          case OverflowPolicy::Fail:
+            status = EnqueueStatus::Rejected;
+            break;
+          case OverflowPolicy::DropNewest:
+            status = EnqueueStatus::DroppedNewest;
+            break;
+          case OverflowPolicy::DropOldest:
+            oldest = PopFront();
+            RecordDequeued(1);
+            status = EnqueueStatus::DroppedOldest;
+            break;
+        }
+      }
+      if (status == EnqueueStatus::Accepted ||
+          status == EnqueueStatus::DroppedOldest) {
+        RecordEnqueued(*callback);
+        PushBack(callback);
+      }
+    }
+    switch (status) {
+      case EnqueueStatus::Rejected:
+        callback->m_linked.store(false, std::memory_order_release);
+        callback->Discard();
+        return status;
+      case EnqueueStatus::DroppedNewest:
+        callback->m_linked.store(false, std::memory_order_release);
+        Drop(callback);
+        return status;
+      case EnqueueStatus::DroppedOldest:
+        Drop(oldest);
+        break;
+      case EnqueueStatus::Accepted:
+        break;
+    }
+    NotifyConsumer();
+    return status;
   }
 
   bool empty() const override {
     std::lock_guard<std::mutex> g(m_mutex);
-    return m_callbacks.empty();
+    return m_head == nullptr;
   }
 
   WrappedCallBasePtr Get() override {
     std::lock_guard<std::mutex> g(m_mutex);
-    if (m_callbacks.empty()) {
+    if (m_head == nullptr) {
       return nullptr;
     }
-    WrappedCallBasePtr callback = m_callbacks.front();
-    m_callbacks.pop_front();
+    WrappedCallBasePtr callback = PopFront();
+    RecordDequeued(1);
+    NotifyProducers();
     return callback;
   }
 
+  std::size_t Drain(Batch& batch, std::size_t max_count) override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    std::size_t count = 0;
+    for (; count < max_count && m_head != nullptr; ++count) {
+      batch.push_back(PopFront());
+    }
+    if (count != 0) {
+      RecordDequeued(count);
+      NotifyProducers();
+    }
+    return count;
+  }
+
+  std::size_t Capacity() const { return m_capacity; }
+  OverflowPolicy Policy() const { return m_policy; }
+
  private:
+  bool IsFull() const {
+    return m_capacity != kUnbounded && m_size >= m_capacity;
+  }
+
+  // Must be called with m_mutex held. The queue holds a reference to every
+  // linked call.
+  void PushBack(const WrappedCallBasePtr& callback) {
+    WrappedCallBase* call = WrappedCallBasePtr(callback).Detach();
+    if (m_tail == nullptr) {
+      m_head = call;
+    } else {
+      m_tail->m_next_queued = call;
+    }
+    m_tail = call;
+    ++m_size;
+  }
+
+  // Must be called with m_mutex held and the queue not empty.
+  WrappedCallBasePtr PopFront() {
+    WrappedCallBase* call = m_head;
+    m_head = std::exchange(call->m_next_queued, nullptr);
+    if (m_head == nullptr) {
+      m_tail = nullptr;
+    }
+    --m_size;
+    call->m_linked.store(false, std::memory_order_release);
+    return WrappedCallBasePtr::Adopt(call);
+  }
+
+  void ReleaseBlockedProducers() override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_not_full.notify_all();
+  }
+
+  // Must be called with m_mutex held.
+  void NotifyProducers() {
+    if (m_blocked_producers != 0) {
+      m_not_full.notify_all();
+    }
+  }
+
   mutable std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::size_t m_blocked_producers{0};
+
+  const std::size_t m_capacity{kUnbounded};
+  const OverflowPolicy m_policy{OverflowPolicy::Block};
 
-  std::list<WrappedCallBaseWPtr> m_weak_callbacks;
-  std::list<WrappedCallBasePtr> m_callbacks;
+  // Calls are linked through WrappedCallBase, so queueing one allocates
+  // nothing.
+  WrappedCallBase* m_head{nullptr};
+  WrappedCallBase* m_tail{nullptr};
+  std::size_t m_size{0};
 };
 
 }  // namespace utils
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <vector>
 
+#include "metrics.hpp"
+#include "overflow_policy.hpp"
+#include "tracer.hpp"
 #include "wrapped_call.hpp"
 
 namespace eh {
@@ -12,12 +20,138 @@ namespace utils {
 
 class ICallbackQueue : public std::enable_shared_from_this<ICallbackQueue> {
  public:
+  using Clock = std::chrono::steady_clock;
+  using Batch = std::vector<WrappedCallBasePtr>;
+
+  static constexpr std::size_t kDrainAll =
+      std::numeric_limits<std::size_t>::max();
+
   virtual ~ICallbackQueue() {}
 
-  virtual void addCallback(const WrappedCallBasePtr& callback) = 0;
+  // Callbacks that do not end up in the queue are discarded, see
+  // WrappedCallBase::Discard.
+  virtual EnqueueStatus addCallback(const WrappedCallBasePtr& callback) = 0;
   virtual WrappedCallBasePtr Get() = 0;
+  // Moves up to max_count pending callbacks, oldest first, to the back of
+  // batch in a single synchronization step. Returns how many were moved.
+  virtual std::size_t Drain(Batch& batch, std::size_t max_count) = 0;
 
   virtual bool empty() const = 0;
+
+  // Number of producers that found the queue full.
+  std::size_t OverflowCount() const { return m_overflows.load(); }
+  // Number of callbacks discarded by the overflow policy.
+  std::size_t DroppedCount() const { return m_dropped.load(); }
+
+  // Callbacks that entered the queue, are pending and were pending at most.
+  // Always zero unless built with EH_ENABLE_METRICS.
+  std::uint64_t EnqueuedCount() const {
+#ifdef EH_ENABLE_METRICS
+    return m_counters.Enqueued();
+#else
+    return 0;
+#endif  // EH_ENABLE_METRICS
+  }
+  std::uint64_t Depth() const {
+#ifdef EH_ENABLE_METRICS
+    return m_counters.Depth();
+#else
+    return 0;
+#endif  // EH_ENABLE_METRICS
+  }
+  std::uint64_t HighWaterMark() const {
+#ifdef EH_ENABLE_METRICS
+    return m_counters.HighWaterMark();
+#else
+    return 0;
+#endif  // EH_ENABLE_METRICS
+  }
+
+  // Parks the consumer until a callback is added, Wake() is called or the
+  // deadline expires. Returns false if the deadline expired.
+  bool WaitForCallback(Clock::time_point deadline = Clock::time_point::max()) {
+    std::unique_lock<std::mutex> lock(m_park_mutex);
+    m_parked.fetch_add(1);
+    // Pairs with the fence in NotifyConsumer: either the producer sees the
+    // consumer parked or the consumer sees the new callback.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto ready = [this] { return m_wake_requested.exchange(false) || !empty(); };
+    bool woken = true;
+    if (deadline == Clock::time_point::max()) {
+      m_park_cv.wait(lock, ready);
+    } else {
+      woken = m_park_cv.wait_until(lock, deadline, ready);
+    }
+    m_parked.fetch_sub(1);
+    return woken;
+  }
+
+  // Wakes a parked consumer even if there is nothing to process. If nobody
+  // is parked, the next WaitForCallback returns immediately.
+  void Wake() {
+    m_wake_requested.store(true);
+    NotifyConsumer();
+  }
+
+  // Called when the consumer stops: producers blocked by
+  // OverflowPolicy::Block, and those finding the queue full until Open(),
+  // drop their callback and get EnqueueStatus::DroppedNewest.
+  void Close() {
+    m_closed.store(true);
+    ReleaseBlockedProducers();
+  }
+  void Open() { m_closed.store(false); }
+  bool IsClosed() const { return m_closed.load(); }
+
+ protected:
+  // Implementations call this right before a callback becomes visible to
+  // Get(), and RecordDequeued for every callback taken out again, be it by
+  // the consumer or the overflow policy.
+  void RecordEnqueued([[maybe_unused]] WrappedCallBase& callback) noexcept {
+#ifdef EH_ENABLE_METRICS
+    callback.SetEnqueueTime(std::chrono::steady_clock::now());
+    m_counters.OnEnqueued();
+#endif  // EH_ENABLE_METRICS
+#ifdef EH_ENABLE_TRACING
+    callback.SetTraceFlow(Tracer::RecordEnqueue());
+#endif  // EH_ENABLE_TRACING
+  }
+  void RecordDequeued([[maybe_unused]] std::size_t count) noexcept {
+#ifdef EH_ENABLE_METRICS
+    m_counters.OnDequeued(count);
+#endif  // EH_ENABLE_METRICS
+  }
+
+  void RecordOverflow() { m_overflows.fetch_add(1, std::memory_order_relaxed); }
+
+  // Wakes producers waiting for room, so they see IsClosed().
+  virtual void ReleaseBlockedProducers() {}
+
+  void Drop(const WrappedCallBasePtr& callback) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    callback->Discard();
+  }
+
+  // Implementations call this once a new callback is visible to Get().
+  void NotifyConsumer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> g(m_park_mutex);
+      m_park_cv.notify_one();
+    }
+  }
+
+ private:
+  std::mutex m_park_mutex;
+  std::condition_variable m_park_cv;
+  std::atomic<std::size_t> m_parked{0};
+  std::atomic_bool m_wake_requested{false};
+  std::atomic_bool m_closed{false};
+  std::atomic<std::size_t> m_overflows{0};
+  std::atomic<std::size_t> m_dropped{0};
+#ifdef EH_ENABLE_METRICS
+  QueueCounters m_counters;
+#endif  // EH_ENABLE_METRICS
 };
 
 using ICallbackQueuePtr = std::shared_ptr<ICallbackQueue>;
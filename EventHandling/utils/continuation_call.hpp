@@ -0,0 +1,88 @@
+#pragma once
+
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "callback_queue_base.hpp"
+#include "inline_invocable.hpp"
+#include "intrusive_ptr.hpp"
+#include "wrapped_call.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Call continuing another one, see Future::Then. Attached to the call it
+// continues, it queues itself to its thread once that call has a result,
+// then passes the result on to the callable. An exception of the first call
+// skips the callable and becomes the result of this one.
+template <typename T, typename U>
+class ContinuationCall final : public WrappedCall<U>, public Continuation {
+ public:
+  using Callable =
+      std::conditional_t<std::is_void_v<T>, InlineInvocable<U>,
+                         InlineInvocable<U, T>>;
+
+  ContinuationCall(const Callable& callable, ICallbackQueuePtr queue)
+      : m_callable(callable), m_queue(std::move(queue)) {
+    static_assert(alignof(ContinuationCall) <= CallPool::kAlignment);
+  }
+
+  // Attaches to antecedent, which the continuation keeps alive until it
+  // ran.
+  void Continue(IntrusivePtr<WrappedCall<T>> antecedent) {
+    m_antecedent = std::move(antecedent);
+    // Reference for the time until Schedule, which may run right here.
+    this->AddRef();
+    m_antecedent->SetContinuation(*this);
+  }
+
+  void Schedule() noexcept override {
+    WrappedCallBasePtr self(this);
+    this->Release();
+    ICallbackQueuePtr queue = std::move(m_queue);
+    if (queue == nullptr) {
+      Perform();
+      return;
+    }
+    try {
+      queue->addCallback(self);
+    } catch (const std::exception&) {
+      this->Discard();
+    }
+  }
+
+  void Perform() override {
+    IntrusivePtr<WrappedCall<T>> antecedent = std::move(m_antecedent);
+    try {
+      if constexpr (std::is_void_v<T>) {
+        antecedent->Retrieve();
+        Complete([this] { return m_callable(); });
+      } else {
+        Complete([&] { return m_callable(antecedent->Retrieve()); });
+      }
+    } catch (const std::exception&) {
+      this->SetException(std::current_exception());
+    }
+  }
+
+ private:
+  template <typename Fn>
+  void Complete(Fn&& fn) {
+    if constexpr (std::is_void_v<U>) {
+      fn();
+      this->SetValue();
+    } else {
+      this->SetValue(fn());
+    }
+  }
+
+  Callable m_callable;
+  ICallbackQueuePtr m_queue;
+  IntrusivePtr<WrappedCall<T>> m_antecedent;
+};
+
+}  // namespace utils
+
+}  // namespace eh
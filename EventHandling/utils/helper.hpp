@@ -1,8 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <type_traits>
 #include <memory>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
 namespace eh {
 
 namespace utils {
@@ -44,6 +52,59 @@ inline constexpr bool is_shared_or_weak_ptr_v =
     is_shared_ptr_v<T> | is_weak_ptr_v<T>; 
 
 
+// Address unique to T. Lets type-erased code check the dynamic type of an
+// object with one pointer comparison instead of dynamic_cast.
+template <typename T>
+inline constexpr char kTypeTag = 0;
+
+template <typename T>
+constexpr const void* TypeTag() noexcept {
+  return &kTypeTag<T>;
+}
+
+inline std::size_t HashCombine(std::size_t seed, std::size_t value) noexcept {
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+// Hashes the object representation of a trivially copyable value, so only
+// use it for types whose equal values have equal bytes.
+template <typename T>
+std::size_t HashBytes(const T& value) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+  std::size_t hash = sizeof(T);
+  std::size_t offset = 0;
+  for (; offset + sizeof(std::size_t) <= sizeof(T);
+       offset += sizeof(std::size_t)) {
+    std::size_t word;
+    std::memcpy(&word, reinterpret_cast<const char*>(&value) + offset,
+                sizeof(word));
+    hash = HashCombine(hash, std::hash<std::size_t>{}(word));
+  }
+  if (offset < sizeof(T)) {
+    std::size_t word = 0;
+    std::memcpy(&word, reinterpret_cast<const char*>(&value) + offset,
+                sizeof(T) - offset);
+    hash = HashCombine(hash, std::hash<std::size_t>{}(word));
+  }
+  return hash;
+}
+
+
+// Used to keep independently written atomics on separate cache lines.
+inline constexpr std::size_t kCacheLineSize = 64;
+
+// Hint to the CPU that the caller is busy-waiting.
+inline void CpuRelax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+
 }  // namespace detail
 
 }  // namespace eh
@@ -0,0 +1,522 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "argument_pack.hpp"
+#include "call_pool.hpp"
+#include "helper.hpp"
+#include "invocable_element.hpp"
+#include "ptr.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Tells the weak copies of an InlineInvocable whether one of its owners,
+// the invocable or a copy of it, is still around.
+class LivenessToken {
+ public:
+  static void* operator new(std::size_t size) {
+    return CallPool::Allocate(size);
+  }
+  static void operator delete(void* block) noexcept {
+    CallPool::Deallocate(block);
+  }
+
+  void AddOwner() noexcept {
+    m_owners.fetch_add(1, std::memory_order_relaxed);
+    AddRef();
+  }
+  void ReleaseOwner() noexcept {
+    m_owners.fetch_sub(1, std::memory_order_release);
+    Release();
+  }
+  bool IsAlive() const noexcept {
+    return m_owners.load(std::memory_order_acquire) != 0;
+  }
+
+  void AddRef() noexcept {
+    m_references.fetch_add(1, std::memory_order_relaxed);
+  }
+  void Release() noexcept {
+    if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+ private:
+  std::atomic<std::uint32_t> m_owners{0};
+  std::atomic<std::uint32_t> m_references{0};
+};
+
+// Type-erased callable with small-buffer storage.
+//
+// Function pointers, bound member functions and callables of up to
+// kInlineSize bytes live inside the object, so creating, copying and
+// destroying them never touches the heap. Bigger callables, and callables
+// that cannot be moved without throwing, are wrapped into a shared
+// InvocableBase exactly like InvocationElementFactory does.
+//
+// The invoke thunk is stored in the object itself, so a call is a single
+// indirect jump. Copying, destroying and comparing go through a per-type
+// table; trivially copyable targets skip it and are copied with memcpy.
+// Function pointers and bound methods are compared and hashed by their
+// bytes, the table address doubling as their type tag. Targets bound at
+// compile time with Bind carry the function in their type, so the thunk
+// calls it directly. Callables that need a non-const call operator are put
+// on the heap too, so copies keep sharing their state.
+template <typename Ret, typename... Args>
+class InlineInvocable {
+  using SharedTarget = InvocableBasePtr<Ret, Args...>;
+  using WeakTarget = InvocableBaseWPtr<Ret, Args...>;
+
+ public:
+  static constexpr std::size_t kInlineSize = 4 * sizeof(void*);
+  static constexpr std::size_t kInlineAlign = alignof(std::max_align_t);
+
+  template <typename T>
+  static constexpr bool kFitsInline =
+      sizeof(T) <= kInlineSize && alignof(T) <= kInlineAlign &&
+      std::is_nothrow_move_constructible_v<T> &&
+      std::is_copy_constructible_v<T>;
+
+  InlineInvocable() noexcept = default;
+  InlineInvocable(std::nullptr_t) noexcept {}
+
+  InlineInvocable(ptr::FunctionPtr<Ret, Args...> func) {
+    if (func != nullptr) {
+      Emplace<ptr::FunctionPtr<Ret, Args...>>(func);
+    }
+  }
+
+  template <typename Object, typename Method>
+  InlineInvocable(Object* object, Method method) {
+    Emplace<BoundMethod<Object, Method>>(object, method);
+  }
+
+  template <typename Callable, typename Decayed = std::decay_t<Callable>,
+            typename = std::enable_if_t<
+                !std::is_same_v<Decayed, InlineInvocable> &&
+                !std::is_same_v<Decayed, SharedTarget> &&
+                std::is_invocable_r_v<Ret, Decayed&, Args...>>>
+  InlineInvocable(Callable&& callable) {
+    if constexpr (kFitsInline<Decayed> &&
+                  std::is_invocable_r_v<Ret, const Decayed&, Args...>) {
+      Emplace<Decayed>(std::forward<Callable>(callable));
+    } else {
+      Emplace<SharedTarget>(InvocationElementFactory<Ret, Args...>::create(
+          Decayed(std::forward<Callable>(callable))));
+    }
+  }
+
+  InlineInvocable(const SharedTarget& invocable) {
+    if (invocable != nullptr) {
+      Emplace<SharedTarget>(invocable);
+    }
+  }
+
+  // Calls Function, which is part of the target's type, so the invoke thunk
+  // calls it directly and the compiler can inline it.
+  template <auto Function>
+  static InlineInvocable Bind() {
+    InlineInvocable invocable;
+    invocable.Emplace<StaticFunction<Function>>();
+    return invocable;
+  }
+
+  // Same for a member function called on object.
+  template <auto Method, typename Object>
+  static InlineInvocable Bind(Object* object) {
+    static_assert(
+        std::is_invocable_r_v<Ret, decltype(Method), Object*, Args...>);
+    InlineInvocable invocable;
+    invocable.Emplace<StaticMethod<Method, Object>>(object);
+    return invocable;
+  }
+
+  InlineInvocable(const InlineInvocable& other) { CopyFrom(other); }
+  InlineInvocable(InlineInvocable&& other) noexcept {
+    MoveFrom(std::move(other));
+  }
+
+  InlineInvocable& operator=(const InlineInvocable& other) {
+    if (this != &other) {
+      reset();
+      CopyFrom(other);
+    }
+    return *this;
+  }
+
+  InlineInvocable& operator=(InlineInvocable&& other) noexcept {
+    if (this != &other) {
+      reset();
+      MoveFrom(std::move(other));
+    }
+    return *this;
+  }
+
+  ~InlineInvocable() { reset(); }
+
+  // Must not be called on an empty object.
+  Ret operator()(Args&&... args) const {
+    if (m_weak && !m_liveness.load(std::memory_order_relaxed)->IsAlive()) {
+      throw ArgumentPackApplyError("The Callable object was already deleted");
+    }
+    return m_invoke(m_storage, std::forward<Args>(args)...);
+  }
+
+  void reset() noexcept {
+    if (m_ops != nullptr && m_ops->destroy != nullptr) {
+      m_ops->destroy(m_storage);
+    }
+    m_invoke = nullptr;
+    m_ops = nullptr;
+    if (LivenessToken* token =
+            m_liveness.exchange(nullptr, std::memory_order_relaxed)) {
+      if (m_weak) {
+        token->Release();
+      } else {
+        token->ReleaseOwner();
+      }
+    }
+    m_weak = false;
+  }
+
+  explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+  // False when the target had to be put on the heap.
+  bool IsInline() const noexcept {
+    return m_ops != &kOps<SharedTarget> && m_ops != &kOps<WeakTarget>;
+  }
+
+  // Copy that does not count as an owner: calling it once this invocable
+  // and its copies are gone throws ArgumentPackApplyError. Heap allocated
+  // targets are held through a weak_ptr, inline ones are copied and checked
+  // against a LivenessToken the owners share from then on.
+  InlineInvocable WeakCopy() const {
+    if (m_ops == &kOps<SharedTarget>) {
+      InlineInvocable weak;
+      weak.Emplace<WeakTarget>(*Get<SharedTarget>(m_storage));
+      return weak;
+    }
+    if (m_ops == nullptr || m_ops == &kOps<WeakTarget> || m_weak) {
+      return *this;
+    }
+    InlineInvocable weak;
+    weak.CopyTargetFrom(*this);
+    LivenessToken* token = SharedLiveness();
+    token->AddRef();
+    weak.m_liveness.store(token, std::memory_order_relaxed);
+    weak.m_weak = true;
+    return weak;
+  }
+
+  bool operator==(const InlineInvocable& other) const {
+    if (m_ops != other.m_ops) {
+      return false;
+    }
+    if (m_ops == nullptr) {
+      return true;
+    }
+    switch (m_ops->identity) {
+      case Identity::Bytes:
+        return std::memcmp(m_storage, other.m_storage, kInlineSize) == 0;
+      case Identity::Value:
+        return m_ops->equals(m_storage, other.m_storage);
+      case Identity::None:
+        break;
+    }
+    return false;
+  }
+
+  bool operator!=(const InlineInvocable& other) const {
+    return !(*this == other);
+  }
+
+  bool operator==(std::nullptr_t) const noexcept { return m_ops == nullptr; }
+  bool operator!=(std::nullptr_t) const noexcept { return m_ops != nullptr; }
+
+  // False when the target never compares equal, not even to a copy of
+  // itself, because its type has no operator==.
+  bool IsComparable() const noexcept {
+    return m_ops != nullptr && m_ops->identity != Identity::None;
+  }
+
+  // Equal objects have equal hashes.
+  std::size_t Hash() const noexcept {
+    if (m_ops == nullptr) {
+      return 0;
+    }
+    const std::size_t kind = std::hash<const void*>{}(m_ops);
+    switch (m_ops->identity) {
+      case Identity::Bytes:
+        return HashCombine(kind, HashBytes(m_storage));
+      case Identity::Value:
+        return m_ops->hash(m_storage);
+      case Identity::None:
+        break;
+    }
+    return kind;
+  }
+
+ private:
+  template <typename Object, typename Method>
+  struct BoundMethod {
+    Ret operator()(Args&&... args) const {
+      return std::invoke(method, object, std::forward<Args>(args)...);
+    }
+    bool operator==(const BoundMethod& other) const {
+      return object == other.object && method == other.method;
+    }
+
+    Object* object;
+    Method method;
+  };
+
+  template <auto Function>
+  struct StaticFunction {
+    Ret operator()(Args&&... args) const {
+      return std::invoke(Function, std::forward<Args>(args)...);
+    }
+  };
+
+  template <auto Method, typename Object>
+  struct StaticMethod {
+    explicit StaticMethod(Object* object) : object(object) {}
+
+    Ret operator()(Args&&... args) const {
+      return std::invoke(Method, object, std::forward<Args>(args)...);
+    }
+
+    Object* object;
+  };
+
+  // Targets that are equal exactly when their bytes are.
+  template <typename T>
+  struct IsPlainTarget
+      : std::bool_constant<std::is_same_v<T, ptr::FunctionPtr<Ret, Args...>>> {
+  };
+
+  template <typename Object, typename Method>
+  struct IsPlainTarget<BoundMethod<Object, Method>> : std::true_type {};
+
+  template <auto Function>
+  struct IsPlainTarget<StaticFunction<Function>> : std::true_type {};
+
+  template <auto Method, typename Object>
+  struct IsPlainTarget<StaticMethod<Method, Object>> : std::true_type {};
+
+  enum class Identity {
+    // Equal exactly when the bytes are; the storage is zero filled first.
+    Bytes,
+    // Compared by the target's operator==.
+    Value,
+    // Never equal.
+    None
+  };
+
+  struct Ops {
+    // nullptr means the target is copied and moved with memcpy.
+    void (*copy)(const void* from, void* to);
+    // Moves the target and destroys the source.
+    void (*move)(void* from, void* to) noexcept;
+    // nullptr means the target is trivially destructible.
+    void (*destroy)(void* storage) noexcept;
+    bool (*equals)(const void* lhs, const void* rhs);
+    std::size_t (*hash)(const void* storage) noexcept;
+    Identity identity;
+  };
+
+  template <typename T>
+  static T* Get(void* storage) noexcept {
+    return std::launder(static_cast<T*>(storage));
+  }
+
+  template <typename T>
+  static const T* Get(const void* storage) noexcept {
+    return std::launder(static_cast<const T*>(storage));
+  }
+
+  template <typename T>
+  static Ret InvokeTarget(void* storage, Args&&... args) {
+    T& target = *Get<T>(storage);
+    if constexpr (std::is_same_v<T, SharedTarget>) {
+      return target->invoke(std::forward<Args>(args)...);
+    } else if constexpr (std::is_same_v<T, WeakTarget>) {
+      if (auto locked = target.lock(); locked != nullptr) {
+        return locked->invoke(std::forward<Args>(args)...);
+      }
+      throw ArgumentPackApplyError("The Callable object was already deleted");
+    } else if constexpr (std::is_void_v<Ret>) {
+      std::invoke(target, std::forward<Args>(args)...);
+    } else {
+      return std::invoke(target, std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename T>
+  static void CopyTarget(const void* from, void* to) {
+    ::new (to) T(*Get<T>(from));
+  }
+
+  template <typename T>
+  static void MoveTarget(void* from, void* to) noexcept {
+    T* source = Get<T>(from);
+    ::new (to) T(std::move(*source));
+    source->~T();
+  }
+
+  template <typename T>
+  static void DestroyTarget(void* storage) noexcept {
+    Get<T>(storage)->~T();
+  }
+
+  template <typename T>
+  static bool EqualTargets(const void* lhs, const void* rhs) {
+    const T& left = *Get<T>(lhs);
+    const T& right = *Get<T>(rhs);
+    if constexpr (std::is_same_v<T, SharedTarget>) {
+      return left == right || *left == *right;
+    } else if constexpr (std::is_same_v<T, WeakTarget>) {
+      auto left_locked = left.lock();
+      auto right_locked = right.lock();
+      return left_locked != nullptr && right_locked != nullptr &&
+             (left_locked == right_locked || *left_locked == *right_locked);
+    } else if constexpr (is_equality_comparable_v<const T>) {
+      return left == right;
+    } else {
+      return false;
+    }
+  }
+
+  // Hash of Identity::Value targets.
+  template <typename T>
+  static std::size_t HashTarget(const void* storage) noexcept {
+    const T& target = *Get<T>(storage);
+    if constexpr (std::is_same_v<T, SharedTarget>) {
+      return target->hash();
+    } else if constexpr (std::is_same_v<T, WeakTarget>) {
+      // Expired targets are not equal to anything.
+      auto locked = target.lock();
+      return locked != nullptr ? locked->hash() : 0;
+    } else {
+      // Arbitrary callables can only be told apart by their type.
+      return std::hash<const void*>{}(&kOps<T>);
+    }
+  }
+
+  template <typename T>
+  static constexpr Identity IdentityOf() {
+    if constexpr (IsPlainTarget<T>::value) {
+      static_assert(std::is_empty_v<T> ||
+                    std::has_unique_object_representations_v<T>);
+      return Identity::Bytes;
+    } else if constexpr (std::is_same_v<T, SharedTarget> ||
+                         std::is_same_v<T, WeakTarget> ||
+                         is_equality_comparable_v<const T>) {
+      return Identity::Value;
+    } else {
+      return Identity::None;
+    }
+  }
+
+  template <typename T>
+  static constexpr Ops kOps{
+      std::is_trivially_copyable_v<T> ? nullptr : &CopyTarget<T>,
+      std::is_trivially_copyable_v<T> ? nullptr : &MoveTarget<T>,
+      std::is_trivially_destructible_v<T> ? nullptr : &DestroyTarget<T>,
+      &EqualTargets<T>, &HashTarget<T>, IdentityOf<T>()};
+
+  template <typename T, typename... CtorArgs>
+  void Emplace(CtorArgs&&... ctor_args) {
+    static_assert(kFitsInline<T>);
+    if constexpr (IdentityOf<T>() == Identity::Bytes) {
+      std::memset(m_storage, 0, kInlineSize);
+    }
+    ::new (static_cast<void*>(m_storage))
+        T(std::forward<CtorArgs>(ctor_args)...);
+    m_invoke = &InvokeTarget<T>;
+    m_ops = &kOps<T>;
+  }
+
+  // Token of the owners, created by the first weak copy.
+  LivenessToken* SharedLiveness() const {
+    LivenessToken* token = m_liveness.load(std::memory_order_acquire);
+    if (token == nullptr) {
+      auto* created = new LivenessToken();
+      created->AddOwner();
+      if (m_liveness.compare_exchange_strong(token, created,
+                                             std::memory_order_acq_rel)) {
+        return created;
+      }
+      created->ReleaseOwner();
+    }
+    return token;
+  }
+
+  void CopyFrom(const InlineInvocable& other) {
+    if (other.m_ops == nullptr) {
+      return;
+    }
+    CopyTargetFrom(other);
+    if (LivenessToken* token =
+            other.m_liveness.load(std::memory_order_acquire)) {
+      if (other.m_weak) {
+        token->AddRef();
+      } else {
+        token->AddOwner();
+      }
+      m_liveness.store(token, std::memory_order_relaxed);
+      m_weak = other.m_weak;
+    }
+  }
+
+  void CopyTargetFrom(const InlineInvocable& other) {
+    if (other.m_ops->copy != nullptr) {
+      other.m_ops->copy(other.m_storage, m_storage);
+    } else {
+      std::memcpy(m_storage, other.m_storage, kInlineSize);
+    }
+    m_invoke = other.m_invoke;
+    m_ops = other.m_ops;
+  }
+
+  void MoveFrom(InlineInvocable&& other) noexcept {
+    if (other.m_ops == nullptr) {
+      return;
+    }
+    if (other.m_ops->move != nullptr) {
+      other.m_ops->move(other.m_storage, m_storage);
+    } else {
+      std::memcpy(m_storage, other.m_storage, kInlineSize);
+    }
+    m_invoke = other.m_invoke;
+    m_ops = other.m_ops;
+    other.m_invoke = nullptr;
+    other.m_ops = nullptr;
+    m_liveness.store(
+        other.m_liveness.exchange(nullptr, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    m_weak = std::exchange(other.m_weak, false);
+  }
+
+  Ret (*m_invoke)(void*, Args&&...) = nullptr;
+  const Ops* m_ops = nullptr;
+  alignas(kInlineAlign) mutable unsigned char m_storage[kInlineSize];
+  // Shared by the owners once a weak copy of an inline target was made. A
+  // weak copy only holds a reference to it and is marked by m_weak.
+  mutable std::atomic<LivenessToken*> m_liveness{nullptr};
+  bool m_weak{false};
+};
+
+}  // namespace utils
+
+}  // namespace eh
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace eh {
+
+namespace utils {
+
+// Owning pointer to an object that counts its own references.
+//
+// T provides AddRef() and Release(); Release() destroys the object once the
+// last reference is gone. Unlike std::shared_ptr there is no separate
+// control block, so creating one costs a single allocation of T itself.
+template <typename T>
+class IntrusivePtr {
+ public:
+  using element_type = T;
+
+  IntrusivePtr() noexcept = default;
+  IntrusivePtr(std::nullptr_t) noexcept {}
+  explicit IntrusivePtr(T* ptr) noexcept : m_ptr(ptr) { Acquire(); }
+
+  IntrusivePtr(const IntrusivePtr& other) noexcept : m_ptr(other.m_ptr) {
+    Acquire();
+  }
+  IntrusivePtr(IntrusivePtr&& other) noexcept
+      : m_ptr(std::exchange(other.m_ptr, nullptr)) {}
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  IntrusivePtr(const IntrusivePtr<U>& other) noexcept : m_ptr(other.get()) {
+    Acquire();
+  }
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  IntrusivePtr(IntrusivePtr<U>&& other) noexcept : m_ptr(other.Detach()) {}
+
+  ~IntrusivePtr() { reset(); }
+
+  IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+    IntrusivePtr(other).swap(*this);
+    return *this;
+  }
+
+  IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+    IntrusivePtr(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  IntrusivePtr& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  void reset() noexcept {
+    if (m_ptr != nullptr) {
+      std::exchange(m_ptr, nullptr)->Release();
+    }
+  }
+
+  void swap(IntrusivePtr& other) noexcept { std::swap(m_ptr, other.m_ptr); }
+
+  T* get() const noexcept { return m_ptr; }
+  T* operator->() const noexcept { return m_ptr; }
+  T& operator*() const noexcept { return *m_ptr; }
+  explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+  // Gives up ownership without releasing the reference.
+  T* Detach() noexcept { return std::exchange(m_ptr, nullptr); }
+
+  // Takes over a reference given up by Detach.
+  static IntrusivePtr Adopt(T* ptr) noexcept {
+    IntrusivePtr adopted;
+    adopted.m_ptr = ptr;
+    return adopted;
+  }
+
+  template <typename U>
+  bool operator==(const IntrusivePtr<U>& other) const noexcept {
+    return m_ptr == other.get();
+  }
+  bool operator==(std::nullptr_t) const noexcept { return m_ptr == nullptr; }
+
+ private:
+  void Acquire() noexcept {
+    if (m_ptr != nullptr) {
+      m_ptr->AddRef();
+    }
+  }
+
+  T* m_ptr{nullptr};
+};
+
+template <typename T, typename... CtorArgs>
+IntrusivePtr<T> MakeIntrusive(CtorArgs&&... ctor_args) {
+  return IntrusivePtr<T>(new T(std::forward<CtorArgs>(ctor_args)...));
+}
+
+template <typename T, typename U>
+IntrusivePtr<T> StaticPointerCast(const IntrusivePtr<U>& ptr) noexcept {
+  return IntrusivePtr<T>(static_cast<T*>(ptr.get()));
+}
+
+}  // namespace utils
+
+}  // namespace eh
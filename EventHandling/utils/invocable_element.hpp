@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -22,7 +23,11 @@ class InvocableBase : public std::enable_shared_from_this<InvocableBase<Ret, Arg
 
   virtual ~InvocableBase() {}
 
-  bool operator==(const InvocableBase& other) const { return equals(other); }
+  // Wrappers of different types never compare equal; the kind tags tell
+  // them apart without RTTI.
+  bool operator==(const InvocableBase& other) const {
+    return m_kind == other.m_kind && equals(other);
+  }
 
   bool operator!=(const InvocableBase& other) const {
     return !(*this == other);
@@ -31,11 +36,19 @@ class InvocableBase : public std::enable_shared_from_this<InvocableBase<Ret, Arg
   Ret operator()(Args&&... args) { return invoke(std::forward<Args>(args)...); }
   virtual Ret invoke(Args&&... args) = 0;
 
+  // Equal invocables have equal hashes.
+  virtual std::size_t hash() const = 0;
+
   Ptr Copy() { return this->shared_from_this(); }
   WPtr WeakCopy() { return this->weak_from_this(); }
 
  protected:
+  explicit InvocableBase(const void* kind) : m_kind(kind) {}
+
+  // Only called with an invocable of the same kind.
   virtual bool equals(const InvocableBase<Ret, Args...>& other) const = 0;
+
+  const void* const m_kind;
 };
 
 template <typename Ret, typename... Args>
@@ -51,17 +64,19 @@ class InvocationElementFactory final {
     using Function = ptr::FunctionPtr<Ret, Args...>;
 
    public:
-    FunctionWrapper(Function function) : m_func(function) {}
+    FunctionWrapper(Function function)
+        : InvocableBase<Ret, Args...>(TypeTag<FunctionWrapper>()),
+          m_func(function) {}
 
     Ret invoke(Args&&... args) override {
       return m_func(std::forward<Args>(args)...);
     }
 
+    std::size_t hash() const override { return HashBytes(m_func); }
+
    private:
     bool equals(const InvocableBase<Ret, Args...>& other) const override {
-      const FunctionWrapper* _other =
-          dynamic_cast<const FunctionWrapper*>(&other);
-      return _other != nullptr && m_func == _other->m_func;
+      return m_func == static_cast<const FunctionWrapper&>(other).m_func;
     }
 
     ptr::FunctionPtr<Ret, Args...> m_func;
@@ -71,18 +86,23 @@ class InvocationElementFactory final {
   class MethodWrapper final : public InvocableBase<Ret, Args...> {
    public:
     MethodWrapper(Object* object, Method method)
-        : m_object(object), m_method(method) {}
+        : InvocableBase<Ret, Args...>(TypeTag<MethodWrapper>()),
+          m_object(object),
+          m_method(method) {}
 
     Ret invoke(Args&&... args) override {
       return std::invoke(m_method, m_object, std::forward<Args>(args)...);
       //return m_object->m_method(std::forward<Args>...);
     }
 
+    std::size_t hash() const override {
+      return HashCombine(HashBytes(m_object), HashBytes(m_method));
+    }
+
    private:
     bool equals(const InvocableBase<Ret, Args...>& other) const override {
-      const MethodWrapper* _other = dynamic_cast<const MethodWrapper*>(&other);
-      return _other != nullptr && m_method == _other->m_method && m_object ==
-                 _other->m_object;
+      const auto& _other = static_cast<const MethodWrapper&>(other);
+      return m_method == _other.m_method && m_object == _other.m_object;
     }
 
     Object* m_object;
@@ -93,22 +113,28 @@ class InvocationElementFactory final {
   class CallableWrapper final : public InvocableBase<Ret, Args...> {
    public:
     CallableWrapper(const Callable& callable)
-        : m_callable(callable) {}
+        : InvocableBase<Ret, Args...>(TypeTag<CallableWrapper>()),
+          m_callable(callable) {}
 
     CallableWrapper(Callable&& callable)
-        : m_callable(std::move(callable)) {}
+        : InvocableBase<Ret, Args...>(TypeTag<CallableWrapper>()),
+          m_callable(std::move(callable)) {}
 
     Ret invoke(Args&&... args) override {
       return m_callable(std::forward<Args>(args)...);
     }
 
+    // Arbitrary callables can only be told apart by their type.
+    std::size_t hash() const override {
+      return std::hash<const void*>{}(TypeTag<CallableWrapper>());
+    }
+
    private:
 
     bool equals(const InvocableBase<Ret, Args...>& other) const override {
       if constexpr (is_equality_comparable_v<Callable>) {
-        const CallableWrapper* _other =
-            dynamic_cast<const CallableWrapper*>(&other);
-        return _other != nullptr && m_callable == _other->m_callable;
+        return m_callable ==
+               static_cast<const CallableWrapper&>(other).m_callable;
       } else {
         return false;
       }
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace eh {
+
+namespace utils {
+
+// Runtime metrics are only collected when the library and its users are
+// compiled with EH_ENABLE_METRICS (the CMake option of the same name).
+// Otherwise the counters below are not even members of the queues and
+// threads, and the snapshots stay zero.
+#ifdef EH_ENABLE_METRICS
+inline constexpr bool kMetricsEnabled = true;
+#else
+inline constexpr bool kMetricsEnabled = false;
+#endif  // EH_ENABLE_METRICS
+
+// Copy of a LogHistogram. Bucket 0 counts zero durations, bucket i > 0
+// those of [2^(i-1), 2^i) nanoseconds.
+struct HistogramSnapshot {
+  static constexpr std::size_t kBuckets = 64;
+
+  std::array<std::uint64_t, kBuckets> counts{};
+  std::uint64_t count{0};
+  std::uint64_t sum_ns{0};
+
+  static std::uint64_t BucketUpperBound(std::size_t bucket) {
+    return bucket == 0 ? 0 : (std::uint64_t{1} << bucket) - 1;
+  }
+
+  // Upper bound in nanoseconds of the bucket the quantile q, in [0, 1],
+  // falls into; 0 if nothing was recorded.
+  std::uint64_t Quantile(double q) const {
+    const auto rank = static_cast<std::uint64_t>(
+        std::clamp(q, 0.0, 1.0) * static_cast<double>(count));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      seen += counts[bucket];
+      if (seen != 0 && seen >= rank) {
+        return BucketUpperBound(bucket);
+      }
+    }
+    return 0;
+  }
+
+  double MeanNs() const {
+    return count == 0 ? 0.0
+                      : static_cast<double>(sum_ns) / static_cast<double>(count);
+  }
+};
+
+// Histogram of durations with power-of-two buckets. Recording is two
+// relaxed atomic increments and never blocks; a snapshot taken meanwhile
+// may be off by the records in flight.
+class LogHistogram {
+ public:
+  static constexpr std::size_t kBuckets = HistogramSnapshot::kBuckets;
+
+  void Record(std::chrono::nanoseconds value) noexcept {
+    const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(
+        value.count(), 0));
+    const std::size_t bucket =
+        std::min<std::size_t>(std::bit_width(ns), kBuckets - 1);
+    m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+  }
+
+  HistogramSnapshot Snapshot() const noexcept {
+    HistogramSnapshot snapshot;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      snapshot.counts[bucket] = m_counts[bucket].load(std::memory_order_relaxed);
+      snapshot.count += snapshot.counts[bucket];
+    }
+    snapshot.sum_ns = m_sum.load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+ private:
+  std::array<std::atomic<std::uint64_t>, kBuckets> m_counts{};
+  std::atomic<std::uint64_t> m_sum{0};
+};
+
+// Counters of a callback queue, updated by its producers and consumer.
+class QueueCounters {
+ public:
+  void OnEnqueued() noexcept {
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    const std::int64_t depth =
+        m_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::int64_t high_water = m_high_water.load(std::memory_order_relaxed);
+    while (depth > high_water &&
+           !m_high_water.compare_exchange_weak(high_water, depth,
+                                               std::memory_order_relaxed)) {
+    }
+  }
+
+  void OnDequeued(std::size_t count) noexcept {
+    m_depth.fetch_sub(static_cast<std::int64_t>(count),
+                      std::memory_order_relaxed);
+  }
+
+  std::uint64_t Enqueued() const noexcept {
+    return m_enqueued.load(std::memory_order_relaxed);
+  }
+  std::uint64_t Depth() const noexcept {
+    return static_cast<std::uint64_t>(
+        std::max<std::int64_t>(m_depth.load(std::memory_order_relaxed), 0));
+  }
+  std::uint64_t HighWaterMark() const noexcept {
+    return static_cast<std::uint64_t>(
+        m_high_water.load(std::memory_order_relaxed));
+  }
+
+ private:
+  std::atomic<std::uint64_t> m_enqueued{0};
+  std::atomic<std::int64_t> m_depth{0};
+  std::atomic<std::int64_t> m_high_water{0};
+};
+
+// What a thread's consumer loop records per callback.
+class ExecutionCounters {
+ public:
+  void OnExecuted(std::chrono::nanoseconds queue_wait,
+                  std::chrono::nanoseconds execution) noexcept {
+    m_executed.fetch_add(1, std::memory_order_relaxed);
+    m_queue_wait.Record(queue_wait);
+    m_execution.Record(execution);
+  }
+
+  std::uint64_t Executed() const noexcept {
+    return m_executed.load(std::memory_order_relaxed);
+  }
+  const LogHistogram& QueueWait() const noexcept { return m_queue_wait; }
+  const LogHistogram& Execution() const noexcept { return m_execution; }
+
+ private:
+  std::atomic<std::uint64_t> m_executed{0};
+  LogHistogram m_queue_wait;
+  LogHistogram m_execution;
+};
+
+}  // namespace utils
+
+// Snapshot of an eh::Thread and its callback queue, see Thread::Metrics.
+struct ThreadMetrics {
+  // Callbacks that made it into the queue.
+  std::uint64_t enqueued{0};
+  // Callbacks the thread performed.
+  std::uint64_t executed{0};
+  // Callbacks discarded by the overflow policy. Counted even without
+  // EH_ENABLE_METRICS, see ICallbackQueue::DroppedCount.
+  std::uint64_t dropped{0};
+  // Callbacks pending when the snapshot was taken, and the most ever.
+  std::uint64_t depth{0};
+  std::uint64_t high_water{0};
+  // Time from entering the queue until the thread started the callback,
+  // and time the callback ran.
+  utils::HistogramSnapshot queue_wait;
+  utils::HistogramSnapshot execution;
+};
+
+}  // namespace eh
@@ -0,0 +1,34 @@
+#pragma once
+
+namespace eh {
+
+namespace utils {
+
+// What a bounded callback queue does when a producer finds it full.
+enum class OverflowPolicy {
+  // Wait until the consumer frees a slot. Once the queue is closed the new
+  // callback is discarded as with DropNewest.
+  Block,
+  // Reject the new callback and report EnqueueStatus::Rejected.
+  Fail,
+  // Silently discard the new callback.
+  DropNewest,
+  // Discard the oldest pending callback to make room for the new one.
+  DropOldest
+};
+
+// Outcome of handing a callback to a queue, ordered from best to worst.
+enum class EnqueueStatus {
+  Accepted,
+  DroppedOldest,
+  DroppedNewest,
+  Rejected
+};
+
+inline EnqueueStatus Worst(EnqueueStatus lhs, EnqueueStatus rhs) {
+  return lhs < rhs ? rhs : lhs;
+}
+
+}  // namespace utils
+
+}  // namespace eh
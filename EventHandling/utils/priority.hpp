@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eh {
+
+namespace utils {
+
+// Dispatch priority of a queued call, honoured by PriorityCallbackQueue.
+enum class Priority : std::uint8_t { Low, Normal, High, Critical };
+
+inline constexpr std::size_t kPriorityLevels = 4;
+
+}  // namespace utils
+
+}  // namespace eh
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "callback_queue_base.hpp"
+#include "priority.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Multi-level queue that hands out callbacks by WrappedCallBase priority,
+// FIFO within a level.
+//
+// A non-empty level that has been passed over starvation_limit times in a
+// row is served next even if higher levels still have work, so a flood of
+// urgent callbacks cannot stall lower priorities forever. Capacity and
+// overflow policy apply to the queue as a whole; DropOldest evicts the
+// oldest callback of the lowest non-empty level.
+class PriorityCallbackQueue : public ICallbackQueue {
+ public:
+  static constexpr std::size_t kUnbounded = 0;
+  static constexpr std::size_t kDefaultStarvationLimit = 32;
+
+  explicit PriorityCallbackQueue(
+      std::size_t capacity = kUnbounded,
+      OverflowPolicy policy = OverflowPolicy::Block,
+      std::size_t starvation_limit = kDefaultStarvationLimit)
+      : m_capacity(capacity),
+        m_policy(policy),
+        m_starvation_limit(starvation_limit) {}
+
+  EnqueueStatus addCallback(const WrappedCallBasePtr& callback) override {
+    EnqueueStatus status = EnqueueStatus::Accepted;
+    WrappedCallBasePtr oldest;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (IsFull()) {
+        RecordOverflow();
+        switch (m_policy) {
+          case OverflowPolicy::Block:
+            ++m_blocked_producers;
+            m_not_full.wait(lock, [this] { return !IsFull() || IsClosed(); });
+            --m_blocked_producers;
+            if (IsFull()) {
+              status = EnqueueStatus::DroppedNewest;
+            }
+            break;
+          case OverflowPolicy::Fail:
+            status = EnqueueStatus::Rejected;
+            break;
+          case OverflowPolicy::DropNewest:
+            status = EnqueueStatus::DroppedNewest;
+            break;
+          case OverflowPolicy::DropOldest:
+            oldest = PopOldestLowest();
+            RecordDequeued(1);
+            status = EnqueueStatus::DroppedOldest;
+            break;
+        }
+      }
+      if (status == EnqueueStatus::Accepted ||
+          status == EnqueueStatus::DroppedOldest) {
+        RecordEnqueued(*callback);
+        m_levels[LevelOf(callback->GetPriority())].push_back(callback);
+        ++m_size;
+      }
+    }
+    switch (status) {
+      case EnqueueStatus::Rejected:
+        callback->Discard();
+        return status;
+      case EnqueueStatus::DroppedNewest:
+        Drop(callback);
+        return status;
+      case EnqueueStatus::DroppedOldest:
+        Drop(oldest);
+        break;
+      case EnqueueStatus::Accepted:
+        break;
+    }
+    NotifyConsumer();
+    return status;
+  }
+
+  WrappedCallBasePtr Get() override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    if (m_size == 0) {
+      return nullptr;
+    }
+    WrappedCallBasePtr callback = PopNext();
+    RecordDequeued(1);
+    NotifyProducers();
+    return callback;
+  }
+
+  std::size_t Drain(Batch& batch, std::size_t max_count) override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    std::size_t count = 0;
+    for (; count < max_count && m_size != 0; ++count) {
+      batch.push_back(PopNext());
+    }
+    if (count != 0) {
+      RecordDequeued(count);
+      NotifyProducers();
+    }
+    return count;
+  }
+
+  bool empty() const override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    return m_size == 0;
+  }
+
+  std::size_t Capacity() const { return m_capacity; }
+  OverflowPolicy Policy() const { return m_policy; }
+  std::size_t StarvationLimit() const { return m_starvation_limit; }
+
+ private:
+  static std::size_t LevelOf(Priority priority) {
+    return static_cast<std::size_t>(priority);
+  }
+
+  bool IsFull() const {
+    return m_capacity != kUnbounded && m_size >= m_capacity;
+  }
+
+  // Must be called with m_mutex held and at least one pending callback.
+  WrappedCallBasePtr PopNext() {
+    std::size_t chosen = kPriorityLevels;
+    for (std::size_t level = kPriorityLevels; level-- > 0;) {
+      if (!m_levels[level].empty()) {
+        if (chosen == kPriorityLevels ||
+            m_skipped[level] >= m_starvation_limit) {
+          chosen = level;
+        }
+        if (m_skipped[level] >= m_starvation_limit) {
+          break;
+        }
+      }
+    }
+    for (std::size_t level = 0; level < kPriorityLevels; ++level) {
+      if (level != chosen && !m_levels[level].empty()) {
+        ++m_skipped[level];
+      }
+    }
+    m_skipped[chosen] = 0;
+    return PopFront(chosen);
+  }
+
+  // Must be called with m_mutex held and at least one pending callback.
+  WrappedCallBasePtr PopOldestLowest() {
+    std::size_t level = 0;
+    while (m_levels[level].empty()) {
+      ++level;
+    }
+    return PopFront(level);
+  }
+
+  WrappedCallBasePtr PopFront(std::size_t level) {
+    WrappedCallBasePtr callback = std::move(m_levels[level].front());
+    m_levels[level].pop_front();
+    if (m_levels[level].empty()) {
+      m_skipped[level] = 0;
+    }
+    --m_size;
+    return callback;
+  }
+
+  void ReleaseBlockedProducers() override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_not_full.notify_all();
+  }
+
+  // Must be called with m_mutex held.
+  void NotifyProducers() {
+    if (m_blocked_producers != 0) {
+      m_not_full.notify_all();
+    }
+  }
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::size_t m_blocked_producers{0};
+
+  const std::size_t m_capacity;
+  const OverflowPolicy m_policy;
+  const std::size_t m_starvation_limit;
+
+  std::array<std::deque<WrappedCallBasePtr>, kPriorityLevels> m_levels;
+  std::array<std::size_t, kPriorityLevels> m_skipped{};
+  std::size_t m_size{0};
+};
+
+}  // namespace utils
+
+}  // namespace eh
@@ -70,6 +70,15 @@ struct FunctionPointer<Ret (*)(Args...)> {
   }
 };
 
+template <typename Ret, typename... Args>
+struct FunctionPointer<Ret (*)(Args...) noexcept> {
+  using ReturnType = Ret;
+  using Function = Ret (*)(Args...) noexcept;
+  using Arguments = std::tuple<Args...>;
+
+  constexpr static bool is_pointer_member = false;
+};
+
 template <typename Obj, typename Ret, typename... Args>
 struct FunctionPointer<ptr::MethodPtr<Obj, Ret, Args...>> {
   using ReturnType = Ret;
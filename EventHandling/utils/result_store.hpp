@@ -1,96 +1,209 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <exception>
+#include <limits>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 //#include <utility>
-#include <future>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "helper.hpp"
 
 namespace eh {
 
 namespace utils {
 
+// One-shot completion shared by the thread producing a result and the
+// threads waiting for it.
+//
+// The state word is published with release semantics after the value or
+// exception is stored, so a waiter that observes it can read the result
+// without further synchronization. Waiters spin briefly and then sleep on
+// the state word itself: a futex on Linux, std::atomic::wait elsewhere. The
+// producer only issues a wake-up when a waiter announced itself. A
+// continuation announces itself the same way, the producer learns about it
+// from the return value of publishing the result.
+class Completion {
+ public:
+  enum class State : std::uint32_t { Pending, Value, Exception };
+
+  State GetState() const noexcept {
+    return static_cast<State>(m_state.load(std::memory_order_acquire) &
+                              kStateMask);
+  }
+  bool IsReady() const noexcept { return GetState() != State::Pending; }
+
+  // Flags the pending result as having a continuation the producer has to
+  // run. False if the result is ready already, then the caller runs it.
+  bool AttachContinuation() noexcept {
+    std::uint32_t state = m_state.load(std::memory_order_relaxed);
+    while ((state & kStateMask) == Pending()) {
+      if (m_state.compare_exchange_weak(state, state | kContinuationFlag,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Wait() const noexcept {
+    for (std::size_t spin = 0; spin < SpinCount(); ++spin) {
+      if (IsReady()) {
+        return;
+      }
+      CpuRelax();
+    }
+    std::uint32_t state = m_state.load(std::memory_order_acquire);
+    while ((state & kStateMask) == Pending()) {
+      if ((state & kWaitersFlag) == 0 &&
+          !m_state.compare_exchange_weak(state, state | kWaitersFlag,
+                                         std::memory_order_acquire)) {
+        continue;
+      }
+      SleepWhile(state | kWaitersFlag);
+      state = m_state.load(std::memory_order_acquire);
+    }
+  }
+
+ protected:
+  // Returns whether a continuation was attached.
+  bool Publish(State state) noexcept {
+    const std::uint32_t previous = m_state.exchange(
+        static_cast<std::uint32_t>(state), std::memory_order_acq_rel);
+    if ((previous & kWaitersFlag) != 0) {
+      WakeAll();
+    }
+    return (previous & kContinuationFlag) != 0;
+  }
+
+ private:
+  static constexpr std::size_t kSpinCount = 128;
+  static constexpr std::uint32_t kStateMask = 0x3;
+  static constexpr std::uint32_t kWaitersFlag = 0x4;
+  static constexpr std::uint32_t kContinuationFlag = 0x8;
+
+  // Spinning only pays off if the producer can run at the same time.
+  static std::size_t SpinCount() noexcept {
+    static const std::size_t spin_count =
+        std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+    return spin_count;
+  }
+
+  static constexpr std::uint32_t Pending() noexcept {
+    return static_cast<std::uint32_t>(State::Pending);
+  }
+
+  // Returns once the state word no longer holds `expected`, or spuriously.
+  void SleepWhile(std::uint32_t expected) const noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<const std::uint32_t*>(&m_state),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    m_state.wait(expected, std::memory_order_acquire);
+#endif
+  }
+
+  void WakeAll() noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<const std::uint32_t*>(&m_state),
+            FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max(), nullptr,
+            nullptr, 0);
+#else
+    m_state.notify_all();
+#endif
+  }
+
+  mutable std::atomic<std::uint32_t> m_state{Pending()};
+};
+
 template <typename T>
-class ResultStore final {
+class ResultStore final : public Completion {
  public:
   T Retrieve() {
-    if (m_value.has_value()) {
-      return std::move(*m_value);
-    }
-    if (m_exception) {
-      std::rethrow_exception(m_exception);
+    switch (GetState()) {
+      case State::Value:
+        return std::move(*m_value);
+      case State::Exception:
+        std::rethrow_exception(m_exception);
+      case State::Pending:
+        break;
     }
     throw std::logic_error("result store is not ready");
   }
 
   const T& Get() const {
-    if (m_value.has_value()) {
-      return *m_value;
-    }
-    if (m_exception) {
-      std::rethrow_exception(m_exception);
+    switch (GetState()) {
+      case State::Value:
+        return *m_value;
+      case State::Exception:
+        std::rethrow_exception(m_exception);
+      case State::Pending:
+        break;
     }
     throw std::logic_error("result store is not ready");
   };
 
-  bool HasValue() const { return m_value.has_value(); }
+  bool HasValue() const { return GetState() == State::Value; }
 
-  void SetValue(const T& value) { 
-    m_value = value;
-    m_promise.set_value(m_value.value());
+  // The setters return whether a continuation was attached.
+  bool SetValue(const T& value) {
+    m_value.emplace(value);
+    return Publish(State::Value);
   }
-  void SetValue(T&& value) { 
+  bool SetValue(T&& value) {
     m_value.emplace(std::move(value));
-    m_promise.set_value(m_value.value());
+    return Publish(State::Value);
   }
-  void SetException(std::exception_ptr&& exception) noexcept {
+  bool SetException(std::exception_ptr&& exception) noexcept {
     m_exception = std::move(exception);
-    m_promise.set_exception(m_exception);
+    return Publish(State::Exception);
   }
 
-  std::future<T> GetFuture() { return std::move(m_promise.get_future()); }
-
  private:
   std::optional<T> m_value;
   std::exception_ptr m_exception;
-  std::promise<T> m_promise;
 };
 
 template <>
-class ResultStore<void> final {
+class ResultStore<void> final : public Completion {
  public:
   void Retrieve() { Get(); }
 
   void Get() const {
-    if (m_has_value) {
-      return;
-    }
-    if (m_exception) {
-      std::rethrow_exception(m_exception);
+    switch (GetState()) {
+      case State::Value:
+        return;
+      case State::Exception:
+        std::rethrow_exception(m_exception);
+      case State::Pending:
+        break;
     }
     throw std::logic_error("result store is not ready");
   };
 
-   bool HasValue() const { return m_has_value; }
+  bool HasValue() const { return GetState() == State::Value; }
 
-  void SetValue() noexcept { 
-    m_has_value = true;
-    m_promise.set_value();
-  }
+  // The setters return whether a continuation was attached.
+  bool SetValue() noexcept { return Publish(State::Value); }
 
-  void SetException(std::exception_ptr&& exception) noexcept {
+  bool SetException(std::exception_ptr&& exception) noexcept {
     m_exception = std::move(exception);
-    m_promise.set_exception(m_exception);
+    return Publish(State::Exception);
   }
 
-  std::future<void> GetFuture() { return std::move(m_promise.get_future()); }
-
  private:
-  bool m_has_value{false};
   std::exception_ptr m_exception;
-  std::promise<void> m_promise;
 };
 
 }  // namespace utils
 
-}  // namespace eh
\ No newline at end of file
+}  // namespace eh
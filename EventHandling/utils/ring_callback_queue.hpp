@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "callback_queue_base.hpp"
+#include "helper.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Bounded lock-free multi-producer/single-consumer queue.
+//
+// Every slot carries a sequence number telling whether it is free for the
+// producer owning position `pos` (sequence == pos) or holds a callback ready
+// for the consumer (sequence == pos + 1). Producers claim positions with a
+// CAS on the enqueue index and the consumer claims whole batches with a CAS
+// on the dequeue index, so nobody contends on a lock. Claiming on the
+// consumer side also lets a producer evict the oldest callback under
+// OverflowPolicy::DropOldest.
+class RingCallbackQueue : public ICallbackQueue {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 1024;
+
+  explicit RingCallbackQueue(std::size_t capacity = kDefaultCapacity,
+                             OverflowPolicy policy = OverflowPolicy::Block)
+      : m_capacity(RoundUpToPowerOfTwo(capacity)),
+        m_mask(m_capacity - 1),
+        m_policy(policy),
+        m_slots(std::make_unique<Slot[]>(m_capacity)) {
+    for (std::size_t i = 0; i < m_capacity; ++i) {
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  EnqueueStatus addCallback(const WrappedCallBasePtr& callback) override {
+    if (TryAdd(callback)) {
+      return EnqueueStatus::Accepted;
+    }
+    RecordOverflow();
+    switch (m_policy) {
+      case OverflowPolicy::Block:
+        for (std::size_t attempt = 0; !TryAdd(callback); ++attempt) {
+          if (IsClosed()) {
+            Drop(callback);
+            return EnqueueStatus::DroppedNewest;
+          }
+          if (attempt < kSpinsBeforeYield) {
+            CpuRelax();
+          } else {
+            std::this_thread::yield();
+          }
+        }
+        return EnqueueStatus::Accepted;
+
+      case OverflowPolicy::Fail:
+        callback->Discard();
+        return EnqueueStatus::Rejected;
+
+      case OverflowPolicy::DropNewest:
+        Drop(callback);
+        return EnqueueStatus::DroppedNewest;
+
+      case OverflowPolicy::DropOldest:
+        break;
+    }
+    bool dropped = false;
+    while (!TryAdd(callback)) {
+      std::size_t pos;
+      if (Claim(1, pos) != 0) {
+        RecordDequeued(1);
+        Drop(Take(pos));
+        dropped = true;
+      } else {
+        CpuRelax();
+      }
+    }
+    return dropped ? EnqueueStatus::DroppedOldest : EnqueueStatus::Accepted;
+  }
+
+  // Adds the callback if there is a free slot, never applies the policy.
+  bool TryAdd(const WrappedCallBasePtr& callback) {
+    std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &m_slots[pos & m_mask];
+      const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    RecordEnqueued(*callback);
+    slot->callback = callback;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    NotifyConsumer();
+    return true;
+  }
+
+  WrappedCallBasePtr Get() override {
+    std::size_t pos;
+    if (Claim(1, pos) == 0) {
+      return nullptr;
+    }
+    RecordDequeued(1);
+    return Take(pos);
+  }
+
+  std::size_t Drain(Batch& batch, std::size_t max_count) override {
+    std::size_t first;
+    const std::size_t count = Claim(max_count, first);
+    for (std::size_t i = 0; i < count; ++i) {
+      batch.push_back(Take(first + i));
+    }
+    RecordDequeued(count);
+    return count;
+  }
+
+  bool empty() const override {
+    const std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) !=
+           pos + 1;
+  }
+
+  std::size_t Capacity() const { return m_capacity; }
+  OverflowPolicy Policy() const { return m_policy; }
+
+ private:
+  static constexpr std::size_t kSpinsBeforeYield = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<std::size_t> sequence;
+    WrappedCallBasePtr callback;
+  };
+
+  static std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 2;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Claims up to max_count consecutive ready positions starting at the
+  // dequeue index. Returns how many were claimed; the first one is stored
+  // in `first`.
+  std::size_t Claim(std::size_t max_count, std::size_t& first) {
+    const std::size_t limit = std::min(max_count, m_capacity);
+    if (limit == 0) {
+      return 0;
+    }
+    std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      std::size_t count = 0;
+      while (count < limit &&
+             m_slots[(pos + count) & m_mask].sequence.load(
+                 std::memory_order_acquire) == pos + count + 1) {
+        ++count;
+      }
+      if (count == 0) {
+        const std::size_t sequence =
+            m_slots[pos & m_mask].sequence.load(std::memory_order_acquire);
+        if (static_cast<std::ptrdiff_t>(sequence - (pos + 1)) < 0) {
+          return 0;
+        }
+        pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (m_dequeue_pos.compare_exchange_weak(pos, pos + count,
+                                              std::memory_order_relaxed)) {
+        first = pos;
+        return count;
+      }
+    }
+  }
+
+  WrappedCallBasePtr Take(std::size_t pos) {
+    Slot& slot = m_slots[pos & m_mask];
+    WrappedCallBasePtr callback = std::move(slot.callback);
+    slot.sequence.store(pos + m_capacity, std::memory_order_release);
+    return callback;
+  }
+
+  const std::size_t m_capacity;
+  const std::size_t m_mask;
+  const OverflowPolicy m_policy;
+  std::unique_ptr<Slot[]> m_slots;
+
+  alignas(kCacheLineSize) std::atomic<std::size_t> m_enqueue_pos{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> m_dequeue_pos{0};
+};
+
+}  // namespace utils
+
+}  // namespace eh
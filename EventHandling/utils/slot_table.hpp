@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "snapshot_cell.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Identifies an element of a SlotTable. Stays valid until the element is
+// erased; a key of an erased element never matches a later one.
+struct SlotKey {
+  std::uint32_t index{0};
+  std::uint32_t generation{0};
+
+  bool IsValid() const noexcept { return generation != 0; }
+  bool operator==(const SlotKey& other) const = default;
+};
+
+// Contiguous table of values that is read without locking and changed in
+// O(1) amortized time.
+//
+// Values are appended to a fixed-capacity array published through a
+// SnapshotCell; readers only look at the prefix that was published when
+// they started. Erasing only clears the slot's alive flag. When the array
+// is full, or half of it is tombstones, the live values are copied into a
+// fresh array that replaces the old one, which readers may keep using
+// until they are done. Keys map to positions through a slot map with
+// generations, so they survive these moves and stale keys are rejected.
+template <typename T>
+class SlotTable {
+  struct Slot {
+    std::optional<T> value;
+    std::uint32_t key{0};
+    std::uint32_t generation{0};
+    std::atomic_bool alive{false};
+  };
+
+  struct Array {
+    Array() = default;
+    explicit Array(std::size_t capacity)
+        : slots(std::make_unique<Slot[]>(capacity)), capacity(capacity) {}
+    Array(Array&& other) noexcept
+        : slots(std::move(other.slots)),
+          capacity(other.capacity),
+          size(other.size.load(std::memory_order_relaxed)),
+          dead(other.dead) {}
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t capacity{0};
+    std::atomic<std::size_t> size{0};
+    // Only touched by writers.
+    std::size_t dead{0};
+  };
+
+ public:
+  // Consistent state of the table: slots appended later are not part of
+  // it, slots erased later may show up as dead. Holding a view delays
+  // reclaiming replaced arrays, so keep it short-lived.
+  class View {
+   public:
+    explicit View(const SlotTable& table)
+        : m_guard(table.m_array.Read()),
+          m_size(m_guard->size.load(std::memory_order_acquire)) {}
+
+    // Number of slots, dead ones included.
+    std::size_t Size() const noexcept { return m_size; }
+    bool IsAlive(std::size_t index) const noexcept {
+      return m_guard->slots[index].alive.load(std::memory_order_acquire);
+    }
+    const T& operator[](std::size_t index) const noexcept {
+      return *m_guard->slots[index].value;
+    }
+    // Key the value at index was inserted with.
+    SlotKey Key(std::size_t index) const noexcept {
+      const Slot& slot = m_guard->slots[index];
+      return SlotKey{slot.key, slot.generation};
+    }
+
+   private:
+    typename SnapshotCell<Array>::ReadGuard m_guard;
+    const std::size_t m_size;
+  };
+
+  SlotTable() : m_writable(&m_array.Store(Array())) {}
+
+  View Read() const { return View(*this); }
+
+  std::size_t LiveCount() const noexcept {
+    return m_live.load(std::memory_order_acquire);
+  }
+
+  SlotKey Insert(T value) {
+    std::lock_guard<std::mutex> g(m_write_mutex);
+    Array* array = m_writable;
+    if (array->size.load(std::memory_order_relaxed) == array->capacity) {
+      array = Rebuild();
+    }
+    const std::size_t position = array->size.load(std::memory_order_relaxed);
+    const std::uint32_t index = AcquireKey(position);
+    Slot& slot = array->slots[position];
+    slot.value.emplace(std::move(value));
+    slot.key = index;
+    slot.generation = m_keys[index].generation;
+    slot.alive.store(true, std::memory_order_relaxed);
+    array->size.store(position + 1, std::memory_order_release);
+    m_live.fetch_add(1, std::memory_order_release);
+    return SlotKey{index, m_keys[index].generation};
+  }
+
+  // Returns false for keys that are stale or were never handed out.
+  bool Erase(const SlotKey& key) {
+    return EraseIf(key, [](const T&) { return true; });
+  }
+
+  // Same, but only erases the value if predicate accepts it.
+  template <typename Predicate>
+  bool EraseIf(const SlotKey& key, Predicate&& predicate) {
+    std::lock_guard<std::mutex> g(m_write_mutex);
+    if (key.index >= m_keys.size() || !m_keys[key.index].used ||
+        m_keys[key.index].generation != key.generation) {
+      return false;
+    }
+    const std::size_t position = m_keys[key.index].position;
+    if (!predicate(*m_writable->slots[position].value)) {
+      return false;
+    }
+    EraseAt(position);
+    return true;
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> g(m_write_mutex);
+    for (std::uint32_t index = 0; index < m_keys.size(); ++index) {
+      if (m_keys[index].used) {
+        ReleaseKey(index);
+      }
+    }
+    m_writable = &m_array.Store(Array());
+    m_live.store(0, std::memory_order_release);
+  }
+
+  std::vector<T> LiveValues() const {
+    std::vector<T> values;
+    const View view = Read();
+    values.reserve(view.Size());
+    for (std::size_t i = 0; i < view.Size(); ++i) {
+      if (view.IsAlive(i)) {
+        values.push_back(view[i]);
+      }
+    }
+    return values;
+  }
+
+ private:
+  SlotTable(const SlotTable&) = delete;
+  SlotTable& operator=(const SlotTable&) = delete;
+
+  static constexpr std::size_t kMinCapacity = 8;
+
+  struct Key {
+    std::size_t position{0};
+    std::uint32_t generation{1};
+    bool used{false};
+  };
+
+  // The methods below must be called with m_write_mutex held.
+
+  void EraseAt(std::size_t position) {
+    Array& array = *m_writable;
+    Slot& slot = array.slots[position];
+    slot.alive.store(false, std::memory_order_release);
+    ReleaseKey(slot.key);
+    ++array.dead;
+    m_live.fetch_sub(1, std::memory_order_release);
+    const std::size_t size = array.size.load(std::memory_order_relaxed);
+    if (size >= kMinCapacity && array.dead * 2 >= size) {
+      Rebuild();
+    }
+  }
+
+  // Copies the live slots into a new array with room to grow and publishes
+  // it. Each live slot is copied once per rebuild and a rebuild follows at
+  // least as many inserts or erases as there are live slots, so the cost is
+  // amortized O(1).
+  Array* Rebuild() {
+    const Array& old_array = *m_writable;
+    const std::size_t live = m_live.load(std::memory_order_relaxed);
+    Array array(std::max(kMinCapacity, live * 2));
+    const std::size_t size = old_array.size.load(std::memory_order_relaxed);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      const Slot& old_slot = old_array.slots[i];
+      if (!old_slot.alive.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      Slot& slot = array.slots[count];
+      slot.value.emplace(*old_slot.value);
+      slot.key = old_slot.key;
+      slot.generation = old_slot.generation;
+      slot.alive.store(true, std::memory_order_relaxed);
+      m_keys[slot.key].position = count;
+      ++count;
+    }
+    array.size.store(count, std::memory_order_relaxed);
+    m_writable = &m_array.Store(std::move(array));
+    return m_writable;
+  }
+
+  std::uint32_t AcquireKey(std::size_t position) {
+    std::uint32_t index;
+    if (!m_free_keys.empty()) {
+      index = m_free_keys.back();
+      m_free_keys.pop_back();
+    } else {
+      index = static_cast<std::uint32_t>(m_keys.size());
+      m_keys.emplace_back();
+    }
+    m_keys[index].position = position;
+    m_keys[index].used = true;
+    return index;
+  }
+
+  void ReleaseKey(std::uint32_t index) {
+    Key& key = m_keys[index];
+    key.used = false;
+    if (++key.generation == 0) {
+      key.generation = 1;
+    }
+    m_free_keys.push_back(index);
+  }
+
+  SnapshotCell<Array> m_array;
+  // The published array; writers may append to it and clear alive flags.
+  Array* m_writable;
+  std::atomic<std::size_t> m_live{0};
+  std::mutex m_write_mutex;
+  std::vector<Key> m_keys;
+  std::vector<std::uint32_t> m_free_keys;
+};
+
+}  // namespace utils
+
+}  // namespace eh
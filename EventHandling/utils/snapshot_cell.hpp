@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "helper.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Holds an immutable value that readers access without locking while
+// writers replace it copy-on-write, RCU style.
+//
+// A reader registers in one of several reader counters, picked per thread
+// so parallel readers do not fight over one cache line, and then loads the
+// current value. A writer copies the value, publishes the modified copy and
+// retires the old one. Retired values are freed once all counters read
+// zero, either by the writer or by the last reader leaving, so a value is
+// never freed while a reader that could have loaded it is still active.
+template <typename T>
+class SnapshotCell {
+  struct Node {
+    T value;
+    Node* next_retired{nullptr};
+  };
+
+ public:
+  class ReadGuard {
+   public:
+    explicit ReadGuard(const SnapshotCell& cell)
+        : m_cell(cell), m_stripe(ThreadStripe()) {
+      m_cell.m_readers[m_stripe].count.fetch_add(1);
+      m_node = m_cell.m_current.load();
+    }
+    ~ReadGuard() { m_cell.Leave(m_stripe); }
+
+    const T& operator*() const noexcept { return m_node->value; }
+    const T* operator->() const noexcept { return &m_node->value; }
+
+   private:
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    const SnapshotCell& m_cell;
+    const std::size_t m_stripe;
+    const Node* m_node;
+  };
+
+  SnapshotCell() : m_current(new Node{}) {}
+  explicit SnapshotCell(T value) : m_current(new Node{std::move(value)}) {}
+
+  ~SnapshotCell() {
+    delete m_current.load();
+    Free(m_retired.exchange(nullptr));
+  }
+
+  // The value stays valid and unchanged while the guard lives.
+  ReadGuard Read() const { return ReadGuard(*this); }
+
+  // Calls update on a copy of the current value and publishes the copy if
+  // update returns true. Writers are serialized, readers are not blocked.
+  template <typename Update>
+  bool Modify(Update&& update) {
+    std::lock_guard<std::mutex> g(m_write_mutex);
+    Node* node = new Node{m_current.load()->value};
+    if (!std::invoke(std::forward<Update>(update), node->value)) {
+      delete node;
+      return false;
+    }
+    Retire(m_current.exchange(node));
+    return true;
+  }
+
+  // Publishes value. The returned reference lets a writer that serializes
+  // its updates itself keep working on the published value, as long as it
+  // only touches what readers do not see yet; it stays valid until the next
+  // write.
+  T& Store(T value) {
+    std::lock_guard<std::mutex> g(m_write_mutex);
+    Node* node = new Node{std::move(value)};
+    Retire(m_current.exchange(node));
+    return node->value;
+  }
+
+ private:
+  SnapshotCell(const SnapshotCell&) = delete;
+  SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+  static constexpr std::size_t kReaderStripes = 8;
+
+  struct alignas(kCacheLineSize) ReaderCount {
+    std::atomic<std::size_t> count{0};
+  };
+
+  static std::size_t ThreadStripe() {
+    static thread_local const std::size_t stripe =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+        kReaderStripes;
+    return stripe;
+  }
+
+  bool HasReaders() const {
+    for (const auto& readers : m_readers) {
+      if (readers.count.load() != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Leave(std::size_t stripe) const {
+    if (m_readers[stripe].count.fetch_sub(1) == 1 &&
+        m_retired.load(std::memory_order_relaxed) != nullptr) {
+      Reclaim();
+    }
+  }
+
+  void Retire(Node* node) {
+    Push(node, node);
+    Reclaim();
+  }
+
+  // Every retired node was unlinked before it is taken off the stack here;
+  // a reader still using one registered before that and is seen by
+  // HasReaders.
+  void Reclaim() const {
+    if (HasReaders()) {
+      return;
+    }
+    Node* retired = m_retired.exchange(nullptr);
+    if (retired == nullptr) {
+      return;
+    }
+    if (!HasReaders()) {
+      Free(retired);
+      return;
+    }
+    Node* last = retired;
+    while (last->next_retired != nullptr) {
+      last = last->next_retired;
+    }
+    Push(retired, last);
+  }
+
+  void Push(Node* first, Node* last) const {
+    Node* head = m_retired.load(std::memory_order_relaxed);
+    do {
+      last->next_retired = head;
+    } while (!m_retired.compare_exchange_weak(head, first));
+  }
+
+  static void Free(Node* node) {
+    while (node != nullptr) {
+      delete std::exchange(node, node->next_retired);
+    }
+  }
+
+  std::atomic<Node*> m_current;
+  mutable std::atomic<Node*> m_retired{nullptr};
+  mutable std::array<ReaderCount, kReaderStripes> m_readers;
+  std::mutex m_write_mutex;
+};
+
+}  // namespace utils
+
+}  // namespace eh
@@ -0,0 +1,238 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <exception>
+#include <utility>
+
+namespace eh {
+
+namespace utils {
+
+TimerWheel::TimerWheel(Clock::duration resolution, Clock::time_point start)
+    : m_start(start),
+      m_resolution(std::max<Clock::duration>(resolution, Clock::duration(1))) {
+  m_heads.fill(kNil);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(Clock::time_point deadline,
+                                         Clock::duration period,
+                                         Callback callback) {
+  std::uint64_t period_ticks = 0;
+  if (period > Clock::duration::zero()) {
+    period_ticks = std::max<std::uint64_t>(
+        1, (period.count() + m_resolution.count() - 1) / m_resolution.count());
+  }
+  std::lock_guard<std::mutex> g(m_mutex);
+  const std::uint32_t index = AllocateNode();
+  Node& node = m_nodes[index];
+  node.callback = std::move(callback);
+  // Slots up to m_current were processed already.
+  node.deadline = std::max(TicksUntil(deadline), m_current + 1);
+  node.period = period_ticks;
+  Link(index);
+  m_count.fetch_add(1, std::memory_order_release);
+  return TimerId{index, node.generation};
+}
+
+bool TimerWheel::Cancel(const TimerId& id) {
+  std::lock_guard<std::mutex> g(m_mutex);
+  if (id.index >= m_nodes.size() || !m_nodes[id.index].used ||
+      m_nodes[id.index].generation != id.generation) {
+    return false;
+  }
+  Unlink(id.index);
+  FreeNode(id.index);
+  return true;
+}
+
+TimerWheel::Clock::time_point TimerWheel::NextDeadline() const {
+  std::lock_guard<std::mutex> g(m_mutex);
+  if (m_count.load(std::memory_order_relaxed) == 0) {
+    return Clock::time_point::max();
+  }
+  const std::uint64_t block_end = m_current | kSlotMask;
+  const std::uint64_t next = NextOccupied(block_end);
+  return TimeOf(next != 0 ? next : block_end + 1);
+}
+
+std::size_t TimerWheel::Advance(Clock::time_point now) {
+  {
+    std::lock_guard<std::mutex> g(m_mutex);
+    const std::uint64_t now_tick =
+        now <= m_start ? 0 : (now - m_start) / m_resolution;
+    while (m_current < now_tick) {
+      if (m_count.load(std::memory_order_relaxed) == 0) {
+        m_current = now_tick;
+        break;
+      }
+      // Skip empty level 0 slots, stopping at the end of the block.
+      const std::uint64_t block_end = m_current | kSlotMask;
+      const std::uint64_t last = std::min(now_tick, block_end);
+      const std::uint64_t next = NextOccupied(last);
+      if (next == 0 && last == now_tick) {
+        m_current = now_tick;
+        break;
+      }
+      m_current = next != 0 ? next : block_end + 1;
+      if ((m_current & kSlotMask) == 0) {
+        Cascade(1);
+      }
+      Expire(now_tick);
+    }
+  }
+  for (auto& expired : m_expired) {
+    try {
+      expired.callback();
+    } catch (const std::exception&) {
+    }
+  }
+  const std::size_t count = m_expired.size();
+  m_expired.clear();
+  return count;
+}
+
+std::uint32_t TimerWheel::AllocateNode() {
+  if (!m_free_nodes.empty()) {
+    const std::uint32_t index = m_free_nodes.back();
+    m_free_nodes.pop_back();
+    m_nodes[index].used = true;
+    return index;
+  }
+  m_nodes.emplace_back().used = true;
+  return static_cast<std::uint32_t>(m_nodes.size() - 1);
+}
+
+void TimerWheel::FreeNode(std::uint32_t index) {
+  Node& node = m_nodes[index];
+  node.callback.reset();
+  node.used = false;
+  if (++node.generation == 0) {
+    node.generation = 1;
+  }
+  m_free_nodes.push_back(index);
+  m_count.fetch_sub(1, std::memory_order_release);
+}
+
+void TimerWheel::Link(std::uint32_t index) {
+  Node& node = m_nodes[index];
+  // The lowest level whose current block contains the deadline.
+  const std::uint64_t difference = node.deadline ^ m_current;
+  std::size_t bucket = kOverflow;
+  for (std::size_t level = 0; level < kLevels; ++level) {
+    if ((difference >> (kSlotBits * (level + 1))) == 0) {
+      bucket = level * kSlots +
+               ((node.deadline >> (kSlotBits * level)) & kSlotMask);
+      break;
+    }
+  }
+  node.bucket = static_cast<std::uint32_t>(bucket);
+  node.prev = kNil;
+  node.next = m_heads[bucket];
+  if (node.next != kNil) {
+    m_nodes[node.next].prev = index;
+  }
+  m_heads[bucket] = index;
+  if (bucket < kSlots) {
+    m_occupied[bucket / 64] |= std::uint64_t{1} << (bucket % 64);
+  }
+}
+
+void TimerWheel::Unlink(std::uint32_t index) {
+  Node& node = m_nodes[index];
+  if (node.prev != kNil) {
+    m_nodes[node.prev].next = node.next;
+  } else {
+    m_heads[node.bucket] = node.next;
+  }
+  if (node.next != kNil) {
+    m_nodes[node.next].prev = node.prev;
+  }
+  if (node.bucket < kSlots && m_heads[node.bucket] == kNil) {
+    m_occupied[node.bucket / 64] &= ~(std::uint64_t{1} << (node.bucket % 64));
+  }
+}
+
+std::uint32_t TimerWheel::TakeBucket(std::size_t bucket) {
+  const std::uint32_t head = std::exchange(m_heads[bucket], kNil);
+  if (bucket < kSlots) {
+    m_occupied[bucket / 64] &= ~(std::uint64_t{1} << (bucket % 64));
+  }
+  return head;
+}
+
+void TimerWheel::Cascade(std::size_t level) {
+  std::size_t bucket = kOverflow;
+  if (level < kLevels) {
+    const std::uint64_t slot = (m_current >> (kSlotBits * level)) & kSlotMask;
+    if (slot == 0) {
+      Cascade(level + 1);
+    }
+    bucket = level * kSlots + slot;
+  }
+  std::uint32_t index = TakeBucket(bucket);
+  while (index != kNil) {
+    const std::uint32_t next = m_nodes[index].next;
+    Link(index);
+    index = next;
+  }
+}
+
+void TimerWheel::Expire(std::uint64_t now_tick) {
+  std::uint32_t index = TakeBucket(m_current & kSlotMask);
+  while (index != kNil) {
+    Node& node = m_nodes[index];
+    const std::uint32_t next = node.next;
+    const TimerId id{index, node.generation};
+    if (node.period == 0) {
+      m_expired.push_back(Expired{id, std::move(node.callback)});
+      FreeNode(index);
+    } else {
+      m_expired.push_back(Expired{id, node.callback});
+      // Periods missed while the thread was busy are skipped.
+      node.deadline += node.period;
+      if (node.deadline <= now_tick) {
+        node.deadline +=
+            ((now_tick - node.deadline) / node.period + 1) * node.period;
+      }
+      Link(index);
+    }
+    index = next;
+  }
+}
+
+std::uint64_t TimerWheel::NextOccupied(std::uint64_t last) const {
+  std::uint64_t slot = (m_current & kSlotMask) + 1;
+  const std::uint64_t last_slot = last & kSlotMask;
+  while (slot <= last_slot && last > m_current) {
+    const std::uint64_t word =
+        m_occupied[slot / 64] & (~std::uint64_t{0} << (slot % 64));
+    if (word != 0) {
+      const std::uint64_t found =
+          (slot & ~std::uint64_t{63}) + std::countr_zero(word);
+      if (found > last_slot) {
+        return 0;
+      }
+      return (m_current & ~kSlotMask) + found;
+    }
+    slot = (slot & ~std::uint64_t{63}) + 64;
+  }
+  return 0;
+}
+
+std::uint64_t TimerWheel::TicksUntil(Clock::time_point time) const {
+  if (time <= m_start) {
+    return 0;
+  }
+  const auto elapsed = (time - m_start).count();
+  return static_cast<std::uint64_t>(
+      (elapsed + m_resolution.count() - 1) / m_resolution.count());
+}
+
+TimerWheel::Clock::time_point TimerWheel::TimeOf(std::uint64_t tick) const {
+  return m_start + m_resolution * static_cast<Clock::rep>(tick);
+}
+
+}  // namespace utils
+
+}  // namespace eh
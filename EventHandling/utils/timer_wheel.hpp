@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "inline_invocable.hpp"
+#include "slot_table.hpp"
+
+namespace eh {
+
+namespace utils {
+
+// Hierarchical timing wheel.
+//
+// Time is counted in ticks of `resolution` since construction. Level 0 has
+// one slot per tick of the current 256-tick block, level n one slot per
+// 256^n-tick block of the current 256^(n+1)-tick block; timers beyond the
+// top level wait in an overflow list. When time enters a new block the
+// timers of its slot one level up are redistributed to the level below.
+// Slots are intrusive doubly-linked lists of pooled nodes, so scheduling
+// and cancelling are O(1) and allocate nothing once the pool has grown.
+//
+// Scheduling and cancelling are thread safe. Advance, which runs the due
+// callbacks, must only be called by one thread at a time. A timer never
+// fires early; it fires on the first Advance at or after its deadline,
+// rounded up to the next tick.
+class TimerWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = InlineInvocable<void>;
+  using TimerId = SlotKey;
+
+  explicit TimerWheel(Clock::duration resolution,
+                      Clock::time_point start = Clock::now());
+
+  // Runs callback at deadline and then every period, if period is not
+  // zero. Returns an id for Cancel.
+  TimerId Schedule(Clock::time_point deadline, Clock::duration period,
+                   Callback callback);
+  // Returns false if the timer already fired, unless it is periodic, or was
+  // cancelled before. A periodic timer may be cancelled from its callback.
+  bool Cancel(const TimerId& id);
+
+  bool Empty() const noexcept {
+    return m_count.load(std::memory_order_acquire) == 0;
+  }
+  std::size_t Size() const noexcept {
+    return m_count.load(std::memory_order_acquire);
+  }
+
+  // No timer fires before the returned time, Clock::time_point::max() if
+  // there are none. May be earlier than the next deadline: timers beyond
+  // the current 256-tick block report the block's end.
+  Clock::time_point NextDeadline() const;
+
+  // Runs the callbacks of all timers due at now, outside the lock.
+  // Exceptions thrown by callbacks are swallowed. Returns the number of
+  // callbacks run.
+  std::size_t Advance(Clock::time_point now);
+
+ private:
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  static constexpr std::size_t kLevels = 4;
+  static constexpr std::size_t kSlotBits = 8;
+  static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+  static constexpr std::uint64_t kSlotMask = kSlots - 1;
+  static constexpr std::size_t kBuckets = kLevels * kSlots;
+  // Bucket index of the overflow list.
+  static constexpr std::size_t kOverflow = kBuckets;
+  static constexpr std::uint32_t kNil = UINT32_MAX;
+
+  struct Node {
+    Callback callback;
+    std::uint64_t deadline{0};
+    std::uint64_t period{0};
+    std::uint32_t prev{kNil};
+    std::uint32_t next{kNil};
+    std::uint32_t bucket{0};
+    std::uint32_t generation{1};
+    bool used{false};
+  };
+
+  struct Expired {
+    TimerId id;
+    Callback callback;
+  };
+
+  // The methods below must be called with m_mutex held.
+  std::uint32_t AllocateNode();
+  void FreeNode(std::uint32_t index);
+  void Link(std::uint32_t index);
+  void Unlink(std::uint32_t index);
+  std::uint32_t TakeBucket(std::size_t bucket);
+  void Cascade(std::size_t level);
+  void Expire(std::uint64_t now_tick);
+  // First occupied level 0 slot in (m_current, last], as a tick; 0 if none.
+  std::uint64_t NextOccupied(std::uint64_t last) const;
+
+  std::uint64_t TicksUntil(Clock::time_point time) const;
+  Clock::time_point TimeOf(std::uint64_t tick) const;
+
+  const Clock::time_point m_start;
+  const Clock::duration m_resolution;
+
+  mutable std::mutex m_mutex;
+  // Last tick Advance processed.
+  std::uint64_t m_current{0};
+  std::atomic<std::size_t> m_count{0};
+  std::vector<Node> m_nodes;
+  std::vector<std::uint32_t> m_free_nodes;
+  std::array<std::uint32_t, kBuckets + 1> m_heads;
+  std::array<std::uint64_t, kSlots / 64> m_occupied{};
+  // Only used by Advance.
+  std::vector<Expired> m_expired;
+};
+
+}  // namespace utils
+
+}  // namespace eh
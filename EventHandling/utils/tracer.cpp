@@ -0,0 +1,261 @@
+#include "tracer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace eh {
+
+namespace utils {
+
+std::atomic_bool Tracer::m_recording{false};
+
+namespace {
+
+enum class EventKind : std::uint64_t { Enqueue, Execute };
+
+struct TraceEvent {
+  EventKind kind;
+  std::uint64_t ts;
+  std::uint64_t dur;
+  std::uint64_t flow;
+};
+
+// Ring of events written by a single thread and read by WriteChromeTrace.
+// A slot is guarded by its sequence, odd while being written, so readers
+// can tell a complete event from one overwritten under their feet.
+class TraceBuffer {
+ public:
+  TraceBuffer(std::uint64_t thread_index, std::size_t capacity)
+      : m_thread_index(thread_index),
+        m_mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1),
+        m_slots(new Slot[m_mask + 1]) {}
+
+  std::uint64_t ThreadIndex() const noexcept { return m_thread_index; }
+
+  void Push(const TraceEvent& event) noexcept {
+    const std::uint64_t pos = m_head.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[pos & m_mask];
+    slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.kind.store(static_cast<std::uint64_t>(event.kind),
+                    std::memory_order_relaxed);
+    slot.ts.store(event.ts, std::memory_order_relaxed);
+    slot.dur.store(event.dur, std::memory_order_relaxed);
+    slot.flow.store(event.flow, std::memory_order_relaxed);
+    slot.sequence.store(2 * pos + 2, std::memory_order_release);
+    m_head.store(pos + 1, std::memory_order_release);
+  }
+
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    const std::uint64_t head = m_head.load(std::memory_order_acquire);
+    const std::uint64_t capacity = m_mask + 1;
+    for (std::uint64_t pos = head > capacity ? head - capacity : 0; pos < head;
+         ++pos) {
+      const Slot& slot = m_slots[pos & m_mask];
+      const std::uint64_t sequence =
+          slot.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * pos + 2) {
+        continue;
+      }
+      TraceEvent event{
+          static_cast<EventKind>(slot.kind.load(std::memory_order_relaxed)),
+          slot.ts.load(std::memory_order_relaxed),
+          slot.dur.load(std::memory_order_relaxed),
+          slot.flow.load(std::memory_order_relaxed)};
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+        fn(event);
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::uint64_t> sequence{0};
+    std::atomic<std::uint64_t> kind{0};
+    std::atomic<std::uint64_t> ts{0};
+    std::atomic<std::uint64_t> dur{0};
+    std::atomic<std::uint64_t> flow{0};
+  };
+
+  const std::uint64_t m_thread_index;
+  const std::size_t m_mask;
+  std::unique_ptr<Slot[]> m_slots;
+  std::atomic<std::uint64_t> m_head{0};
+};
+
+using TraceBufferPtr = std::shared_ptr<TraceBuffer>;
+
+// Buffers of the current recording. Threads only come here for their
+// first event of a recording.
+class TraceRegistry {
+ public:
+  static TraceRegistry& Instance() {
+    static TraceRegistry* instance = new TraceRegistry();
+    return *instance;
+  }
+
+  void Reset(std::size_t events_per_thread) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_buffers.clear();
+    m_events_per_thread = events_per_thread;
+    m_origin.store(Tracer::Clock::now().time_since_epoch().count(),
+                   std::memory_order_relaxed);
+    m_session.fetch_add(1, std::memory_order_release);
+  }
+
+  std::uint64_t Session() const noexcept {
+    return m_session.load(std::memory_order_acquire);
+  }
+
+  std::uint64_t Since(Tracer::Clock::time_point time) const noexcept {
+    const auto origin = Tracer::Clock::time_point(
+        Tracer::Clock::duration(m_origin.load(std::memory_order_relaxed)));
+    return static_cast<std::uint64_t>(std::max<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time - origin)
+            .count(),
+        0));
+  }
+
+  TraceBufferPtr Allocate(std::uint64_t thread_index, std::uint64_t& session) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    auto buffer =
+        std::make_shared<TraceBuffer>(thread_index, m_events_per_thread);
+    m_buffers.push_back(buffer);
+    session = m_session.load(std::memory_order_relaxed);
+    return buffer;
+  }
+
+  std::vector<TraceBufferPtr> Buffers() const {
+    std::lock_guard<std::mutex> g(m_mutex);
+    return m_buffers;
+  }
+
+ private:
+  mutable std::mutex m_mutex;
+  std::vector<TraceBufferPtr> m_buffers;
+  std::size_t m_events_per_thread{Tracer::kDefaultEventsPerThread};
+  std::atomic<Tracer::Clock::rep> m_origin{0};
+  std::atomic<std::uint64_t> m_session{0};
+};
+
+// Flow ids carry the index of the thread that made them, so threads hand
+// them out without sharing a counter.
+constexpr int kFlowThreadShift = 40;
+
+std::atomic<std::uint64_t> next_thread_index{1};
+
+struct LocalTrace {
+  std::uint64_t thread_index{
+      next_thread_index.fetch_add(1, std::memory_order_relaxed)};
+  std::uint64_t flows{0};
+  std::uint64_t session{0};
+  TraceBufferPtr buffer;
+};
+
+thread_local LocalTrace local_trace;
+
+// Buffer of the calling thread for the current recording, nullptr if it
+// could not be allocated.
+TraceBuffer* CurrentBuffer() noexcept {
+  const std::uint64_t session = TraceRegistry::Instance().Session();
+  if (local_trace.buffer == nullptr || local_trace.session != session) {
+    try {
+      local_trace.buffer = TraceRegistry::Instance().Allocate(
+          local_trace.thread_index, local_trace.session);
+    } catch (const std::bad_alloc&) {
+      local_trace.buffer.reset();
+      return nullptr;
+    }
+  }
+  return local_trace.buffer.get();
+}
+
+// Chrome trace timestamps are in microseconds.
+void WriteMicroseconds(std::ostream& out, std::uint64_t ns) {
+  const std::uint64_t fraction = ns % 1000;
+  out << ns / 1000 << '.' << (fraction < 100 ? "0" : "")
+      << (fraction < 10 ? "0" : "") << fraction;
+}
+
+void WriteEvent(std::ostream& out, std::uint64_t tid, const TraceEvent& event,
+                bool& first) {
+  const bool enqueue = event.kind == EventKind::Enqueue;
+  out << (first ? "\n" : ",\n") << R"({"name":")"
+      << (enqueue ? "enqueue" : "execute")
+      << R"(","cat":"eh","ph":"X","pid":1,"tid":)" << tid << R"(,"ts":)";
+  WriteMicroseconds(out, event.ts);
+  out << R"(,"dur":)";
+  WriteMicroseconds(out, event.dur);
+  out << '}';
+  first = false;
+  if (event.flow == 0) {
+    return;
+  }
+  out << ",\n"
+      << R"({"name":"dispatch","cat":"eh","ph":")" << (enqueue ? "s" : "f")
+      << (enqueue ? "" : R"(","bp":"e)") << R"(","id":)" << event.flow
+      << R"(,"pid":1,"tid":)" << tid << R"(,"ts":)";
+  WriteMicroseconds(out, event.ts);
+  out << '}';
+}
+
+}  // namespace
+
+void Tracer::Start(std::size_t events_per_thread) {
+  TraceRegistry::Instance().Reset(events_per_thread);
+  m_recording.store(true, std::memory_order_release);
+}
+
+void Tracer::Stop() { m_recording.store(false, std::memory_order_release); }
+
+void Tracer::WriteChromeTrace(std::ostream& out) {
+  bool first = true;
+  out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+  for (const auto& buffer : TraceRegistry::Instance().Buffers()) {
+    buffer->ForEach([&](const TraceEvent& event) {
+      WriteEvent(out, buffer->ThreadIndex(), event, first);
+    });
+  }
+  out << "\n]}\n";
+}
+
+std::uint64_t Tracer::RecordEnqueue() noexcept {
+  if (!IsRecording()) {
+    return 0;
+  }
+  TraceBuffer* buffer = CurrentBuffer();
+  if (buffer == nullptr) {
+    return 0;
+  }
+  const std::uint64_t flow =
+      (local_trace.thread_index << kFlowThreadShift) | ++local_trace.flows;
+  buffer->Push({EventKind::Enqueue,
+                TraceRegistry::Instance().Since(Clock::now()), 0, flow});
+  return flow;
+}
+
+void Tracer::RecordExecute(std::uint64_t flow, Clock::time_point start,
+                           Clock::time_point end) noexcept {
+  if (!IsRecording()) {
+    return;
+  }
+  TraceBuffer* buffer = CurrentBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+  const TraceRegistry& registry = TraceRegistry::Instance();
+  const std::uint64_t ts = registry.Since(start);
+  buffer->Push({EventKind::Execute, ts,
+                std::max(registry.Since(end), ts) - ts, flow});
+}
+
+}  // namespace utils
+
+}  // namespace eh
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace eh {
+
+namespace utils {
+
+// The queue and thread hooks feeding the Tracer are only compiled in with
+// EH_ENABLE_TRACING (the CMake option of the same name). Without it the
+// Tracer can still be used directly, but nothing records into it.
+#ifdef EH_ENABLE_TRACING
+inline constexpr bool kTracingEnabled = true;
+#else
+inline constexpr bool kTracingEnabled = false;
+#endif  // EH_ENABLE_TRACING
+
+// Records how queued calls travel between threads and writes them as a
+// Chrome trace (chrome://tracing, ui.perfetto.dev).
+//
+// Every call entering a callback queue gets an "enqueue" slice on the
+// producing thread, and an "execute" slice on the thread that performs
+// it, linked by a flow arrow. Each thread records into a buffer of its
+// own: a fixed ring of events written without locks or allocation, so
+// recording costs a few relaxed stores per event. Once a ring is full the
+// oldest events are overwritten. Writing the trace reads the rings
+// concurrently and skips events that are being overwritten meanwhile.
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::size_t kDefaultEventsPerThread = std::size_t{1} << 14;
+
+  // Starts a new recording, dropping the events of the previous one. Each
+  // thread allocates its ring, rounded up to a power of two, on the first
+  // event it records.
+  static void Start(std::size_t events_per_thread = kDefaultEventsPerThread);
+  static void Stop();
+  static bool IsRecording() noexcept {
+    return m_recording.load(std::memory_order_relaxed);
+  }
+
+  // Writes the events of the current or last recording as Chrome trace
+  // event JSON. Safe to call while threads keep recording.
+  static void WriteChromeTrace(std::ostream& out);
+
+  // Records an enqueue slice and returns the id of its flow, 0 when not
+  // recording.
+  static std::uint64_t RecordEnqueue() noexcept;
+  // Records an execute slice, ending flow unless it is 0.
+  static void RecordExecute(std::uint64_t flow, Clock::time_point start,
+                            Clock::time_point end) noexcept;
+
+ private:
+  static std::atomic_bool m_recording;
+};
+
+}  // namespace utils
+
+}  // namespace eh
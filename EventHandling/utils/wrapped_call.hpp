@@ -1,76 +1,353 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "argument_pack.hpp"
-#include "invocable_element.hpp"
+#include "call_pool.hpp"
+#include "inline_invocable.hpp"
+#include "intrusive_ptr.hpp"
+#include "metrics.hpp"
+#include "priority.hpp"
 #include "result_store.hpp"
 
 namespace eh {
 
+class Thread;
+
+namespace delegates {
+
+template <typename Ret, typename... Args>
+class Delegate;
+
+}  // namespace delegates
+
 namespace utils {
 
+class CallbackDroppedError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Calls are reference counted in place and allocated from CallPool, so
+// queueing one costs no global allocator call in the steady state.
 class WrappedCallBase {
  public:
-  using Ptr = std::shared_ptr<WrappedCallBase>;
-  using WPtr = std::weak_ptr<WrappedCallBase>;
+  using Ptr = IntrusivePtr<WrappedCallBase>;
 
   WrappedCallBase(WrappedCallBase&&) = delete;
   virtual ~WrappedCallBase() {}
+
+  static void* operator new(std::size_t size) {
+    return CallPool::Allocate(size);
+  }
+  static void operator delete(void* block) noexcept {
+    CallPool::Deallocate(block);
+  }
+
+  void AddRef() const noexcept {
+    m_references.fetch_add(1, std::memory_order_relaxed);
+  }
+  void Release() const noexcept {
+    if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
   virtual void Perform() = 0;
+  // Completes the call with CallbackDroppedError instead of performing it.
+  virtual void Discard() noexcept = 0;
+
+  Priority GetPriority() const noexcept { return m_priority; }
+  void SetPriority(Priority priority) noexcept { m_priority = priority; }
+
+#ifdef EH_ENABLE_METRICS
+  // When the call last entered a callback queue.
+  std::chrono::steady_clock::time_point EnqueueTime() const noexcept {
+    return m_enqueued_at;
+  }
+  void SetEnqueueTime(std::chrono::steady_clock::time_point time) noexcept {
+    m_enqueued_at = time;
+  }
+#endif  // EH_ENABLE_METRICS
+#ifdef EH_ENABLE_TRACING
+  // Flow linking the enqueue and execute slices of the call, see Tracer.
+  std::uint64_t TraceFlow() const noexcept { return m_trace_flow; }
+  void SetTraceFlow(std::uint64_t flow) noexcept { m_trace_flow = flow; }
+#endif  // EH_ENABLE_TRACING
 
  private:
+  friend class CallBackQueue;
+
+  mutable std::atomic<std::uint32_t> m_references{0};
+  Priority m_priority{Priority::Normal};
+  // Link of the CallBackQueue the call waits in. A call is linked into one
+  // of them at a time, m_linked tells whether it is.
+  WrappedCallBase* m_next_queued{nullptr};
+  std::atomic_bool m_linked{false};
+#ifdef EH_ENABLE_METRICS
+  std::chrono::steady_clock::time_point m_enqueued_at;
+#endif  // EH_ENABLE_METRICS
+#ifdef EH_ENABLE_TRACING
+  std::uint64_t m_trace_flow{0};
+#endif  // EH_ENABLE_TRACING
+
  protected:
   WrappedCallBase() noexcept = default;
+
+  // False for calls no IntrusivePtr owns, e.g. ones on the stack.
+  bool IsShared() const noexcept {
+    return m_references.load(std::memory_order_relaxed) != 0;
+  }
 };
 
 using WrappedCallBasePtr = WrappedCallBase::Ptr;
-using WrappedCallBaseWPtr = WrappedCallBase::WPtr;
+
+template <typename T>
+class Future;
+
+// What a WrappedCall runs once its result is set, see Future::Then.
+class Continuation {
+ public:
+  // Called exactly once, on the thread that set the result or, if it was
+  // set already, on the one attaching the continuation.
+  virtual void Schedule() noexcept = 0;
+
+ protected:
+  ~Continuation() = default;
+};
 
 template <typename T>
 class WrappedCall : public WrappedCallBase {
  public:
   WrappedCall(WrappedCall&&) = delete;
   bool HasValue() const { return m_result.HasValue(); }
+  bool IsReady() const { return m_result.IsReady(); }
   T Retrieve() { return m_result.Retrieve(); }
   decltype(auto) Get() const { return m_result.Get(); }
-  std::future<T> GetFuture() { return std::move(m_result.GetFuture()); }
+  // Blocks until the call was performed or discarded.
+  void Wait() const { m_result.Wait(); }
+  // The returned future keeps the call alive, so the call must have been
+  // created with MakeIntrusive. Throws std::logic_error otherwise.
+  Future<T> GetFuture();
+
+  // Schedules continuation once the result is set, right away if it is set
+  // already. A call takes one continuation at most.
+  void SetContinuation(Continuation& continuation) {
+    if (m_continuation != nullptr) {
+      throw std::logic_error("The call already has a continuation");
+    }
+    m_continuation = &continuation;
+    if (!m_result.AttachContinuation()) {
+      continuation.Schedule();
+    }
+  }
+
+  void Discard() noexcept override {
+    SetException(std::make_exception_ptr(
+        CallbackDroppedError("The call was dropped by a full callback queue")));
+  }
 
  protected:
   WrappedCall() noexcept = default;
-  ResultStore<T>& GetResultStore() noexcept { return m_result; }
+
+  template <typename... Value>
+  void SetValue(Value&&... value) {
+    if (m_result.SetValue(std::forward<Value>(value)...)) {
+      m_continuation->Schedule();
+    }
+  }
+  void SetException(std::exception_ptr error) noexcept {
+    if (m_result.SetException(std::move(error))) {
+      m_continuation->Schedule();
+    }
+  }
 
  private:
   ResultStore<T> m_result;
+  Continuation* m_continuation{nullptr};
 };
 
 template <typename Ret, typename... Args>
 class WrappedCallImpl final : public WrappedCall<Ret> {
  public:
-  using Callable = std::shared_ptr<InvocableBase<Ret, Args...>>;
+  using Callable = InlineInvocable<Ret, Args...>;
 
+  // Heap allocated callables are only referenced weakly, a call whose
+  // delegate is gone fails with ArgumentPackApplyError.
   explicit WrappedCallImpl(const Callable& callable, Args&&... args)
-      : m_callable(callable), m_args(std::forward<Args>(args)...) {}
+      : m_callable(callable.WeakCopy()), m_args(std::forward<Args>(args)...) {
+    static_assert(alignof(WrappedCallImpl) <= CallPool::kAlignment);
+  }
 
   void Perform() override {
-    auto& result = this->GetResultStore();
     try {
       if constexpr (std::is_void_v<Ret>) {
         m_args.Apply(m_callable);
-        result.SetValue();
+        this->SetValue();
       } else {
-        result.SetValue(m_args.Apply(m_callable));
+        this->SetValue(m_args.Apply(m_callable));
       }
     } catch (const std::exception&) {
-      result.SetException(std::current_exception());
+      this->SetException(std::current_exception());
+    }
+  }
+
+ private:
+  Callable m_callable;
+  ArgumentPack<Args...> m_args;
+};
+
+// Runs several callables with one set of arguments, in order, as a single
+// queued call. Each callable gets its own copy of the arguments. The first
+// exception thrown is kept as the result, the other callables still run.
+template <typename... Args>
+class FanOutCall final : public WrappedCall<void> {
+ public:
+  using Callable = InlineInvocable<void, Args...>;
+  using Callables = std::shared_ptr<const std::vector<Callable>>;
+
+  explicit FanOutCall(Callables callables, Args&&... args)
+      : m_callables(std::move(callables)),
+        m_args(std::forward<Args>(args)...) {
+    static_assert(alignof(FanOutCall) <= CallPool::kAlignment);
+  }
+
+  void Perform() override {
+    std::exception_ptr error;
+    for (const Callable& callable : *m_callables) {
+      try {
+        ArgumentPack<Args...>(m_args).Apply(callable);
+      } catch (const std::exception&) {
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error != nullptr) {
+      SetException(std::move(error));
+    } else {
+      SetValue();
     }
   }
 
  private:
-  std::weak_ptr<InvocableBase<Ret, Args...>> m_callable;
+  Callables m_callables;
   ArgumentPack<Args...> m_args;
 };
 
+// Call that is queued at most once at a time: arguments given while it is
+// still pending replace the pending ones, so the callable only sees the
+// latest. Performing it also makes it ready for the next Update. Like
+// queued void calls, it reports nothing back; exceptions are swallowed.
+template <typename... Args>
+class ConflatedCall final : public WrappedCallBase {
+ public:
+  using Callable = InlineInvocable<void, Args...>;
+
+  explicit ConflatedCall(const Callable& callable)
+      : m_callable(callable.WeakCopy()) {
+    static_assert(alignof(ConflatedCall) <= CallPool::kAlignment);
+  }
+
+  // Stores the arguments for the next Perform. Returns true if the call
+  // was not pending and has to be queued by the caller.
+  bool Update(Args&&... args) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_args.emplace(std::forward<Args>(args)...);
+    return !std::exchange(m_pending, true);
+  }
+
+  void Perform() override {
+    std::optional<ArgumentPack<Args...>> args;
+    {
+      std::lock_guard<std::mutex> g(m_mutex);
+      if (!m_args.has_value()) {
+        return;
+      }
+      args.emplace(*m_args);
+      m_args.reset();
+      m_pending = false;
+    }
+    try {
+      args->Apply(m_callable);
+    } catch (const std::exception&) {
+    }
+  }
+
+  void Discard() noexcept override {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_args.reset();
+    m_pending = false;
+  }
+
+ private:
+  Callable m_callable;
+  std::mutex m_mutex;
+  std::optional<ArgumentPack<Args...>> m_args;
+  bool m_pending{false};
+};
+
+// Result of a WrappedCall, a replacement for std::future without a separate
+// shared state: waiting goes straight to the call's ResultStore.
+template <typename T>
+class Future {
+ public:
+  Future() noexcept = default;
+  explicit Future(IntrusivePtr<WrappedCall<T>> call) noexcept
+      : m_call(std::move(call)) {}
+
+  bool valid() const noexcept { return m_call != nullptr; }
+  bool IsReady() const { return m_call->IsReady(); }
+  void wait() const { m_call->Wait(); }
+
+  // Waits for the result and releases the call, the future is invalid
+  // afterwards.
+  T get() {
+    IntrusivePtr<WrappedCall<T>> call = std::move(m_call);
+    call->Wait();
+    return call->Retrieve();
+  }
+
+  // Queues continuation to thread with the result once it is ready and
+  // returns the continuation's future; nobody blocks in between. If the
+  // call failed, continuation is skipped and the returned future holds the
+  // exception. Like get, this takes one continuation and leaves the future
+  // invalid. Defined in delegate.hpp.
+  template <typename U>
+  Future<U> Then(const std::shared_ptr<Thread>& thread,
+                 const delegates::Delegate<U, T>& continuation)
+    requires(!std::is_void_v<T>);
+  template <typename U>
+  Future<U> Then(const std::shared_ptr<Thread>& thread,
+                 const delegates::Delegate<U>& continuation)
+    requires std::is_void_v<T>;
+
+ private:
+  template <typename U, typename Delegate>
+  Future<U> ContinueWith(const std::shared_ptr<Thread>& thread,
+                         const Delegate& continuation);
+
+  IntrusivePtr<WrappedCall<T>> m_call;
+};
+
+template <typename T>
+Future<T> WrappedCall<T>::GetFuture() {
+  if (!IsShared()) {
+    throw std::logic_error("The call is not owned by an IntrusivePtr");
+  }
+  return Future<T>(IntrusivePtr<WrappedCall<T>>(this));
+}
+
 }  // namespace utils
 
 }  // namespace eh
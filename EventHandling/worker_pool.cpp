@@ -0,0 +1,109 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+namespace eh {
+
+namespace {
+
+thread_local const WorkerPool* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+
+}  // namespace
+
+WorkerPool::WorkerPool(std::size_t size) {
+  if (size == 0) {
+    size = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_workers.reserve(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    m_workers.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    m_workers[i]->m_thread = std::thread(&WorkerPool::WorkerFunc, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> g(m_park_mutex);
+    m_is_running = false;
+  }
+  m_park_cv.notify_all();
+  for (auto& worker : m_workers) {
+    if (worker->m_thread.joinable()) {
+      worker->m_thread.join();
+    }
+  }
+  for (auto& worker : m_workers) {
+    for (auto& call : worker->m_calls) {
+      call->Discard();
+    }
+  }
+}
+
+void WorkerPool::Submit(const utils::WrappedCallBasePtr& call) {
+  const std::size_t index =
+      IsWorkerThread() ? current_worker
+                       : m_next_worker.fetch_add(1, std::memory_order_relaxed) %
+                             m_workers.size();
+  {
+    std::lock_guard<std::mutex> g(m_workers[index]->m_mutex);
+    m_workers[index]->m_calls.push_back(call);
+  }
+  m_pending.fetch_add(1);
+  if (m_parked.load() != 0) {
+    std::lock_guard<std::mutex> g(m_park_mutex);
+    m_park_cv.notify_one();
+  }
+}
+
+std::size_t WorkerPool::Size() const { return m_workers.size(); }
+
+bool WorkerPool::IsWorkerThread() const { return current_pool == this; }
+
+void WorkerPool::WorkerFunc(std::size_t index) {
+  current_pool = this;
+  current_worker = index;
+  while (m_is_running) {
+    auto call = Pop(index);
+    if (call == nullptr) {
+      call = Steal(index);
+    }
+    if (call != nullptr) {
+      m_pending.fetch_sub(1);
+      call->Perform();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_park_mutex);
+    m_parked.fetch_add(1);
+    m_park_cv.wait(lock, [this] { return m_pending.load() != 0 || !m_is_running; });
+    m_parked.fetch_sub(1);
+  }
+}
+
+utils::WrappedCallBasePtr WorkerPool::Pop(std::size_t index) {
+  Worker& worker = *m_workers[index];
+  std::lock_guard<std::mutex> g(worker.m_mutex);
+  if (worker.m_calls.empty()) {
+    return nullptr;
+  }
+  auto call = std::move(worker.m_calls.front());
+  worker.m_calls.pop_front();
+  return call;
+}
+
+utils::WrappedCallBasePtr WorkerPool::Steal(std::size_t thief) {
+  for (std::size_t i = 1; i < m_workers.size(); ++i) {
+    Worker& victim = *m_workers[(thief + i) % m_workers.size()];
+    std::lock_guard<std::mutex> g(victim.m_mutex);
+    if (!victim.m_calls.empty()) {
+      auto call = std::move(victim.m_calls.back());
+      victim.m_calls.pop_back();
+      return call;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace eh
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/wrapped_call.hpp"
+
+namespace eh {
+
+// Fixed set of worker threads running InvokeType::Async calls.
+//
+// Every worker owns a deque. Calls submitted from a worker go to its own
+// deque, other submissions are spread round-robin; a worker that runs out
+// of work steals from the others before parking.
+class WorkerPool {
+ public:
+  // A size of 0 uses std::thread::hardware_concurrency().
+  explicit WorkerPool(std::size_t size = 0);
+  ~WorkerPool();
+
+  void Submit(const utils::WrappedCallBasePtr& call);
+  std::size_t Size() const;
+  // True when called from one of this pool's workers.
+  bool IsWorkerThread() const;
+
+ private:
+  WorkerPool(const WorkerPool& other) = delete;
+  WorkerPool(WorkerPool&& other) = delete;
+
+  struct Worker {
+    std::mutex m_mutex;
+    std::deque<utils::WrappedCallBasePtr> m_calls;
+    std::thread m_thread;
+  };
+
+  void WorkerFunc(std::size_t index);
+  utils::WrappedCallBasePtr Pop(std::size_t index);
+  utils::WrappedCallBasePtr Steal(std::size_t thief);
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<std::size_t> m_next_worker{0};
+  std::atomic<std::size_t> m_pending{0};
+  std::atomic<std::size_t> m_parked{0};
+  std::atomic_bool m_is_running{true};
+  std::mutex m_park_mutex;
+  std::condition_variable m_park_cv;
+};
+
+}  // namespace eh
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate.hpp>
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/event_system.h>
+#include <EventHandling/utils/invocable_element.hpp>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <thread>
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+int Sum(int a, int b) { return a + b; }
+
+// InvokeType::Async round trip. With state.range(0) == 0 every call gets a
+// thread of its own, otherwise it runs on the EventSystem worker pool.
+void BM_AsyncInvoke(benchmark::State& state) {
+  const bool use_pool = state.range(0) != 0;
+  if (use_pool) {
+    eh::EventSystem::Init();
+  }
+  QueuedInternalExecutor<int, int, int> executor;
+  auto invocable = InvocationElementFactory<int, int, int>::create(Sum);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(executor.Execute(invocable, 1, 2, InvokeType::Async));
+  }
+  if (use_pool) {
+    eh::EventSystem::Release();
+  }
+}
+
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+Detached SumFlow(eh::ThreadPtr origin, eh::ThreadPtr target,
+                 const Delegate<int, int, int>& d, std::atomic_int& finished) {
+  co_await eh::resume_on(origin);
+  benchmark::DoNotOptimize(co_await d.InvokeOn(target, 1, 2));
+  finished.fetch_add(1, std::memory_order_release);
+}
+
+// state.range(0) coroutines at once each await one call on the target
+// thread and resume on the origin thread; no thread blocks meanwhile.
+void BM_CoroutineInvokeOn(benchmark::State& state) {
+  const auto flows = static_cast<int>(state.range(0));
+  eh::EventSystem::Init(1);
+  auto origin = eh::Thread::CreateRegistered();
+  auto target = eh::Thread::CreateRegistered();
+  auto d = bind<&Sum>();
+
+  for (auto _ : state) {
+    std::atomic_int finished{0};
+    for (int i = 0; i < flows; ++i) {
+      SumFlow(origin, target, d, finished);
+    }
+    while (finished.load(std::memory_order_acquire) != flows) {
+      std::this_thread::yield();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * flows);
+
+  origin->Stop();
+  target->Stop();
+  eh::EventSystem::Release();
+}
+
+}  // namespace
+
+BENCHMARK(BM_CoroutineInvokeOn)
+    ->RangeMultiplier(16)
+    ->Range(1, 4096)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_AsyncInvoke)
+    ->ArgName("pool")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/callback_queue.hpp>
+#include <EventHandling/utils/invocable_element.hpp>
+#include <EventHandling/utils/ring_callback_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+void Noop() {}
+
+std::atomic_size_t performed{0};
+
+void Count() { performed.fetch_add(1, std::memory_order_release); }
+
+// state.range(0) producers push into one queue drained by the benchmark
+// thread; reports callbacks moved through the queue per second.
+template <typename Queue>
+void BM_QueueThroughput(benchmark::State& state) {
+  const auto producers_count = static_cast<std::size_t>(state.range(0));
+  constexpr std::size_t kCallsPerProducer = 1 << 14;
+
+  auto invocable = InvocationElementFactory<void>::create(Noop);
+  WrappedCallBasePtr call = MakeIntrusive<WrappedCallImpl<void>>(invocable);
+
+  for (auto _ : state) {
+    Queue queue;
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < producers_count; ++i) {
+      producers.emplace_back([&] {
+        for (std::size_t j = 0; j < kCallsPerProducer; ++j) {
+          queue.addCallback(call);
+        }
+      });
+    }
+    std::size_t consumed = 0;
+    while (consumed < producers_count * kCallsPerProducer) {
+      if (queue.Get() != nullptr) {
+        ++consumed;
+      }
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * producers_count *
+                          kCallsPerProducer);
+}
+
+// BlockQueued round trip to a spinning thread backed by the given queue.
+void BM_QueueRoundTrip(benchmark::State& state) {
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::Spin;
+  options.queue_type = static_cast<eh::CallbackQueueType>(state.range(0));
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto invocable = InvocationElementFactory<void>::create(Noop);
+
+  for (auto _ : state) {
+    executor.Execute(invocable, InvokeType::BlockQueued);
+  }
+  th->Stop();
+}
+
+// Same with a Queued call: the caller polls until the call has run, so no
+// result store is involved. Both sides yield while waiting, so the numbers
+// stay meaningful with fewer cores than threads.
+void BM_QueuedRoundTrip(benchmark::State& state) {
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::SpinYield;
+  options.spin_count = 1;
+  options.queue_type = static_cast<eh::CallbackQueueType>(state.range(0));
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto invocable = InvocationElementFactory<void>::create(Count);
+
+  for (auto _ : state) {
+    const std::size_t target = performed.load(std::memory_order_relaxed) + 1;
+    executor.Execute(invocable, InvokeType::Queued);
+    while (performed.load(std::memory_order_acquire) != target) {
+      std::this_thread::yield();
+    }
+  }
+  th->Stop();
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_QueueThroughput, CallBackQueue)
+    ->ArgName("producers")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_QueueThroughput, RingCallbackQueue)
+    ->ArgName("producers")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_QueueRoundTrip)
+    ->ArgName("queue")
+    ->Arg(static_cast<int>(eh::CallbackQueueType::List))
+    ->Arg(static_cast<int>(eh::CallbackQueueType::Ring))
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_QueuedRoundTrip)
+    ->ArgName("queue")
+    ->Arg(static_cast<int>(eh::CallbackQueueType::List))
+    ->Arg(static_cast<int>(eh::CallbackQueueType::Ring))
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,159 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate.hpp>
+
+#include <string>
+
+using namespace eh::delegates;
+
+namespace {
+
+int Sum(int a, int b) { return a + b; }
+
+class Accumulator {
+ public:
+  int Add(int a, int b) { return m_total += a + b; }
+
+ private:
+  int m_total{0};
+};
+
+// Creates and destroys a delegate per iteration; none of these allocate.
+void BM_DelegateCreateFunction(benchmark::State& state) {
+  for (auto _ : state) {
+    auto d = delegate<int, int, int>(Sum);
+    benchmark::DoNotOptimize(d);
+  }
+}
+
+void BM_DelegateCreateMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  for (auto _ : state) {
+    auto d = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+    benchmark::DoNotOptimize(d);
+  }
+}
+
+void BM_DelegateCreateLambda(benchmark::State& state) {
+  int offset = 1;
+  for (auto _ : state) {
+    auto d = delegate<int, int, int>(
+        [offset](int a, int b) { return a + b + offset; });
+    benchmark::DoNotOptimize(d);
+  }
+}
+
+// Captures more than fits inline, falls back to a heap allocated target.
+void BM_DelegateCreateLargeLambda(benchmark::State& state) {
+  std::string prefix(64, 'x');
+  for (auto _ : state) {
+    auto d = delegate<int, int, int>([prefix](int a, int b) {
+      return a + b + static_cast<int>(prefix.size());
+    });
+    benchmark::DoNotOptimize(d);
+  }
+}
+
+void BM_DelegateInvokeFunction(benchmark::State& state) {
+  auto d = delegate<int, int, int>(Sum);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d(1, 2));
+  }
+}
+
+void BM_DelegateInvokeMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  auto d = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d(1, 2));
+  }
+}
+
+void BM_DelegateInvokeBoundFunction(benchmark::State& state) {
+  auto d = bind<&Sum>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d(1, 2));
+  }
+}
+
+void BM_DelegateInvokeBoundMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  auto d = bind<&Accumulator::Add>(&accumulator);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d(1, 2));
+  }
+}
+
+// The heap allocated wrappers with a virtual invoke, for comparison.
+void BM_InvocableInvokeFunction(benchmark::State& state) {
+  auto invocable =
+      eh::utils::InvocationElementFactory<int, int, int>::create(Sum);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(invocable->invoke(1, 2));
+  }
+}
+
+void BM_InvocableInvokeMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  auto invocable = eh::utils::InvocationElementFactory<int, int, int>::create(
+      &accumulator, &Accumulator::Add);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(invocable->invoke(1, 2));
+  }
+}
+
+void BM_DelegateInvokeLambda(benchmark::State& state) {
+  int offset = 1;
+  auto d = delegate<int, int, int>(
+      [offset](int a, int b) { return a + b + offset; });
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d(1, 2));
+  }
+}
+
+// Compares equal delegates that are not copies of each other, so the
+// callables themselves are compared.
+void BM_DelegateEqualsMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  auto d = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  auto other = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d == other);
+  }
+}
+
+void BM_DelegateEqualsThroughInterface(benchmark::State& state) {
+  Accumulator accumulator;
+  auto d = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  auto other = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  const IDelegate<int, int, int>& base = d;
+  const IDelegate<int, int, int>& other_base = other;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(base == other_base);
+  }
+}
+
+void BM_DelegateHashMethod(benchmark::State& state) {
+  Accumulator accumulator;
+  auto d = delegate<int, int, int>(&accumulator, &Accumulator::Add);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d.Hash());
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_DelegateCreateFunction);
+BENCHMARK(BM_DelegateCreateMethod);
+BENCHMARK(BM_DelegateCreateLambda);
+BENCHMARK(BM_DelegateCreateLargeLambda);
+BENCHMARK(BM_DelegateInvokeFunction);
+BENCHMARK(BM_DelegateInvokeMethod);
+BENCHMARK(BM_DelegateInvokeLambda);
+BENCHMARK(BM_DelegateInvokeBoundFunction);
+BENCHMARK(BM_DelegateInvokeBoundMethod);
+BENCHMARK(BM_InvocableInvokeFunction);
+BENCHMARK(BM_InvocableInvokeMethod);
+BENCHMARK(BM_DelegateEqualsMethod);
+BENCHMARK(BM_DelegateEqualsThroughInterface);
+BENCHMARK(BM_DelegateHashMethod);
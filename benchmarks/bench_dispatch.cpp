@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/wrapped_call.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+std::atomic<std::size_t> processed{0};
+
+void Process(std::size_t count) {
+  processed.fetch_add(count, std::memory_order_relaxed);
+}
+
+// Creating and releasing a call on the same thread: pooled and intrusively
+// counted against the std::make_shared equivalent.
+void BM_WrappedCallPooled(benchmark::State& state) {
+  InlineInvocable<void, std::size_t> invocable(Process);
+  for (auto _ : state) {
+    auto call = MakeIntrusive<WrappedCallImpl<void, std::size_t>>(invocable, 1);
+    benchmark::DoNotOptimize(call.get());
+  }
+}
+
+void BM_WrappedCallMakeShared(benchmark::State& state) {
+  InlineInvocable<void, std::size_t> invocable(Process);
+  for (auto _ : state) {
+    auto call =
+        std::make_shared<WrappedCallImpl<void, std::size_t>>(invocable, 1);
+    benchmark::DoNotOptimize(call.get());
+  }
+}
+
+// Queued calls to a spinning thread; reports calls per second including the
+// time needed to drain the queue.
+void BM_QueuedDispatch(benchmark::State& state) {
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::Spin;
+  options.queue_type = static_cast<eh::CallbackQueueType>(state.range(0));
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  QueuedInternalExecutor<void, std::size_t> executor(th->CallbackQueue());
+  InlineInvocable<void, std::size_t> invocable(Process);
+
+  const std::size_t start = processed.load();
+  for (auto _ : state) {
+    executor.Execute(invocable, 1, InvokeType::Queued);
+  }
+  const auto target = start + static_cast<std::size_t>(state.iterations());
+  while (processed.load() < target) {
+    std::this_thread::yield();
+  }
+  th->Stop();
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_WrappedCallPooled);
+BENCHMARK(BM_WrappedCallMakeShared);
+
+BENCHMARK(BM_QueuedDispatch)
+    ->ArgName("queue")
+    ->Arg(static_cast<int>(eh::CallbackQueueType::List))
+    ->Arg(static_cast<int>(eh::CallbackQueueType::Ring))
+    ->UseRealTime();
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/event.hpp>
+#include <EventHandling/event_system.h>
+#include <EventHandling/static_event.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace eh;
+
+namespace {
+
+int total = 0;
+
+void OnFirst(int value) { total += value; }
+void OnSecond(int value) { total ^= value; }
+
+void BM_EventSyncTrigger(benchmark::State& state) {
+  events::Event<int> event;
+  event.AddHandler(delegates::bind<&OnFirst>());
+  event.AddHandler(delegates::bind<&OnSecond>());
+  for (auto _ : state) {
+    event.SyncTrigger(1);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+// Same handlers, known at compile time.
+void BM_StaticEventSyncTrigger(benchmark::State& state) {
+  events::StaticEvent<void(int), &OnFirst, &OnSecond> event;
+  for (auto _ : state) {
+    event.SyncTrigger(1);
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+// AsyncTrigger to state.range(0) handlers that all live on one thread,
+// until every handler ran. They are posted to the thread as one call.
+void BM_EventAsyncTriggerFanOut(benchmark::State& state) {
+  EventSystem::Init(1);
+  auto th = Thread::CreateRegistered();
+  const auto handlers = static_cast<int>(state.range(0));
+  std::atomic_int received{0};
+  events::Event<int> event;
+  for (int i = 0; i < handlers; ++i) {
+    auto h = events::handler<int>([&received](int value) {
+      received.fetch_add(value, std::memory_order_release);
+    });
+    h.SetThreadId(th->ThreadId());
+    event.AddHandler(h);
+  }
+  int expected = 0;
+  for (auto _ : state) {
+    event.AsyncTrigger(1);
+    expected += handlers;
+    while (received.load(std::memory_order_acquire) != expected) {
+      std::this_thread::yield();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * handlers);
+  th->Stop();
+  EventSystem::Release();
+}
+
+// What a DelegateExecutor pays for the first dispatch to a thread, from
+// state.threads() threads at once.
+void BM_FindRegisteredThread(benchmark::State& state) {
+  static ThreadPtr th;
+  if (state.thread_index() == 0) {
+    EventSystem::Init(1);
+    th = Thread::CreateRegistered();
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Thread::FindRegistered(th->ThreadId()));
+  }
+  if (state.thread_index() == 0) {
+    th->Stop();
+    th = nullptr;
+    EventSystem::Release();
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_EventSyncTrigger);
+BENCHMARK(BM_StaticEventSyncTrigger);
+BENCHMARK(BM_EventAsyncTriggerFanOut)->Arg(1)->Arg(50);
+BENCHMARK(BM_FindRegisteredThread)->ThreadRange(1, 8);
@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/multicast_delegate.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace eh::delegates;
+
+namespace {
+
+constexpr int kHandlers = 4;
+
+void Work(int value) { benchmark::DoNotOptimize(value * value); }
+
+MulticastDelegate<void, int>& SharedDelegate() {
+  static MulticastDelegate<void, int>* md = [] {
+    auto* md = new MulticastDelegate<void, int>();
+    for (int i = 0; i < kHandlers; ++i) {
+      *md += delegate<void, int>(Work);
+    }
+    return md;
+  }();
+  return *md;
+}
+
+// Every benchmark thread triggers the same multicast delegate.
+void BM_MulticastInvoke(benchmark::State& state) {
+  auto& md = SharedDelegate();
+  for (auto _ : state) {
+    md(1);
+  }
+  state.SetItemsProcessed(state.iterations() * kHandlers);
+}
+
+// Single-threaded Invoke of a delegate with state.range(0) handlers.
+void BM_MulticastInvokeHandlers(benchmark::State& state) {
+  MulticastDelegate<void, int> md;
+  for (int i = 0; i < state.range(0); ++i) {
+    md += delegate<void, int>(Work);
+  }
+  for (auto _ : state) {
+    md(1);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Same, while thread 0 keeps adding and removing a handler.
+void BM_MulticastInvokeWhileModified(benchmark::State& state) {
+  auto& md = SharedDelegate();
+  auto transient = delegate<void, int>(Work);
+  for (auto _ : state) {
+    if (state.thread_index() == 0) {
+      md += transient;
+      md -= transient;
+    } else {
+      md(1);
+    }
+  }
+}
+
+// Handler of the disconnect benchmarks: the same function for every
+// subscriber with duplicates, otherwise a distinct callable each.
+Delegate<void, int> Subscriber(bool duplicates) {
+  return duplicates ? delegate<void, int>(Work)
+                    : delegate<void, int>([](int value) { Work(value); });
+}
+
+// Subscribes state.range(0) handlers, then unsubscribes them all in the
+// order they were added.
+void BM_DisconnectByConnection(benchmark::State& state) {
+  const auto subscribers = static_cast<std::size_t>(state.range(0));
+  const bool duplicates = state.range(1) != 0;
+  std::vector<Connection> connections(subscribers);
+  for (auto _ : state) {
+    MulticastDelegate<void, int> md;
+    for (auto& connection : connections) {
+      connection = md += Subscriber(duplicates);
+    }
+    for (const auto& connection : connections) {
+      md.Disconnect(connection);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_DisconnectByDelegate(benchmark::State& state) {
+  const auto subscribers = static_cast<std::size_t>(state.range(0));
+  const bool duplicates = state.range(1) != 0;
+  std::vector<Delegate<void, int>> handlers;
+  for (std::size_t i = 0; i < subscribers; ++i) {
+    handlers.push_back(Subscriber(duplicates));
+  }
+  for (auto _ : state) {
+    MulticastDelegate<void, int> md;
+    for (const auto& handler : handlers) {
+      md += handler;
+    }
+    for (const auto& handler : handlers) {
+      md -= handler;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_MulticastInvoke)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_MulticastInvokeHandlers)->ArgName("handlers")->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK(BM_MulticastInvokeWhileModified)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK(BM_DisconnectByConnection)
+    ->ArgNames({"subscribers", "duplicates"})
+    ->ArgsProduct({{1 << 10, 1 << 12, 1 << 14}, {0, 1}});
+BENCHMARK(BM_DisconnectByDelegate)
+    ->ArgNames({"subscribers", "duplicates"})
+    ->ArgsProduct({{1 << 10, 1 << 12, 1 << 14}, {0, 1}});
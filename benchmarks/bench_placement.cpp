@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/thread_placement.h>
+#include <EventHandling/utils/invocable_element.hpp>
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif  // __linux__
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+void Noop() {}
+
+enum class Distance { SameCore, SameNode, OtherNode };
+
+// CPU of the producer and, for the given distance, of the consumer.
+std::optional<std::pair<std::size_t, std::size_t>> PickCpus(Distance distance) {
+  std::vector<std::size_t> home = eh::NumaNodeCpus(0);
+  if (home.empty()) {
+    home = {0};
+  }
+  switch (distance) {
+    case Distance::SameCore:
+      return std::make_pair(home[0], home[0]);
+    case Distance::SameNode:
+      if (home.size() > 1) {
+        return std::make_pair(home[0], home[1]);
+      }
+      break;
+    case Distance::OtherNode: {
+      const std::vector<std::size_t> remote = eh::NumaNodeCpus(1);
+      if (!remote.empty()) {
+        return std::make_pair(home[0], remote[0]);
+      }
+      break;
+    }
+  }
+  return std::nullopt;
+}
+
+// Round trip of a BlockQueued call from a producer pinned to one CPU to an
+// eh::Thread pinned to the same CPU, another CPU of its NUMA node or a CPU
+// of another node, with the queue allocated on the consumer's node.
+void BM_PinnedRoundTrip(benchmark::State& state) {
+#ifdef __linux__
+  const auto cpus = PickCpus(static_cast<Distance>(state.range(0)));
+  if (!cpus.has_value()) {
+    state.SkipWithError("not enough CPUs or NUMA nodes");
+    return;
+  }
+  cpu_set_t previous;
+  sched_getaffinity(0, sizeof(previous), &previous);
+  eh::ThreadOptions producer;
+  producer.cpu_affinity = {cpus->first};
+  eh::ApplyThreadPlacement(producer);
+
+  eh::ThreadOptions options;
+  options.cpu_affinity = {cpus->second};
+  options.name = "eh-bench-pinned";
+  if (state.range(0) == static_cast<int>(Distance::OtherNode)) {
+    options.numa_node = 1;
+  }
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto invocable = InvocationElementFactory<void>::create(Noop);
+
+  for (auto _ : state) {
+    executor.Execute(invocable, InvokeType::BlockQueued);
+  }
+
+  th->Stop();
+  sched_setaffinity(0, sizeof(previous), &previous);
+#else
+  state.SkipWithError("thread placement needs Linux");
+#endif  // __linux__
+}
+
+}  // namespace
+
+BENCHMARK(BM_PinnedRoundTrip)
+    ->ArgName("distance")
+    ->Arg(static_cast<int>(Distance::SameCore))
+    ->Arg(static_cast<int>(Distance::SameNode))
+    ->Arg(static_cast<int>(Distance::OtherNode))
+    ->Unit(benchmark::kMicrosecond);
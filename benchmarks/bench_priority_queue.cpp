@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/invocable_element.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+void Noop() {}
+
+void BulkWork() {
+  const auto until =
+      std::chrono::steady_clock::now() + std::chrono::microseconds(1);
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+double Percentile(std::vector<double>& samples, double fraction) {
+  const auto index = static_cast<std::size_t>(fraction * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return samples[index];
+}
+
+// BlockQueued round trip of a High priority call while another thread keeps
+// the target queue full of Low priority bulk work.
+void BM_HighPriorityUnderFlood(benchmark::State& state) {
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::Spin;
+  options.queue_type = static_cast<eh::CallbackQueueType>(state.range(0));
+  options.queue_capacity = 4096;
+  options.batch_size = 8;
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+
+  std::atomic_bool flooding{true};
+  std::thread flood([&] {
+    QueuedInternalExecutor<void> executor(th->CallbackQueue());
+    auto bulk = InvocationElementFactory<void>::create(BulkWork);
+    while (flooding) {
+      executor.Execute(bulk, InvokeType::Queued, Priority::Low);
+    }
+  });
+
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto urgent = InvocationElementFactory<void>::create(Noop);
+  std::vector<double> samples;
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    executor.Execute(urgent, InvokeType::BlockQueued, Priority::High);
+    const auto end = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(end - start).count();
+    state.SetIterationTime(elapsed);
+    samples.push_back(elapsed * 1e6);
+  }
+
+  flooding = false;
+  flood.join();
+  th->Stop();
+
+  state.counters["p50_us"] = Percentile(samples, 0.50);
+  state.counters["p99_us"] = Percentile(samples, 0.99);
+  state.counters["p999_us"] = Percentile(samples, 0.999);
+}
+
+}  // namespace
+
+BENCHMARK(BM_HighPriorityUnderFlood)
+    ->ArgName("queue")
+    ->Arg(static_cast<int>(eh::CallbackQueueType::List))
+    ->Arg(static_cast<int>(eh::CallbackQueueType::Priority))
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
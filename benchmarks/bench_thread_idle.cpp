@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/invocable_element.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+using namespace eh::delegates;
+using namespace eh::utils;
+
+namespace {
+
+void Noop() {}
+
+// Round trip of a BlockQueued call to a thread that has been idle for
+// state.range(1) microseconds. The "cpu" counter is the CPU time the whole
+// process burned per second of wall time, i.e. the cost of staying idle.
+void BM_IdleWakeLatency(benchmark::State& state) {
+  eh::ThreadOptions options;
+  options.idle_strategy = static_cast<eh::IdleStrategy>(state.range(0));
+  const auto idle_time = std::chrono::microseconds(state.range(1));
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto invocable = InvocationElementFactory<void>::create(Noop);
+
+  const std::clock_t cpu_start = std::clock();
+  const auto wall_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    std::this_thread::sleep_for(idle_time);
+    const auto start = std::chrono::steady_clock::now();
+    executor.Execute(invocable, InvokeType::BlockQueued);
+    const auto end = std::chrono::steady_clock::now();
+    state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+  }
+  const double cpu_seconds =
+      static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  const double wall_seconds = std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - wall_start)
+                                  .count();
+  state.counters["cpu"] = cpu_seconds / wall_seconds;
+
+  th->Stop();
+}
+
+}  // namespace
+
+BENCHMARK(BM_IdleWakeLatency)
+    ->ArgNames({"strategy", "idle_us"})
+    ->ArgsProduct({{static_cast<int>(eh::IdleStrategy::Spin),
+                    static_cast<int>(eh::IdleStrategy::SpinYield),
+                    static_cast<int>(eh::IdleStrategy::SpinPark)},
+                   {100, 1000}})
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
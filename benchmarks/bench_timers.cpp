@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/utils/timer_wheel.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace eh::utils;
+
+namespace {
+
+using Clock = TimerWheel::Clock;
+
+// Schedules and cancels state.range(0) timeouts with deadlines spread over
+// ten minutes, the pattern of request timeouts that rarely fire.
+void BM_TimerScheduleCancel(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const Clock::time_point start{};
+  TimerWheel wheel(std::chrono::milliseconds(1), start);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> delay_ms(1, 600000);
+  std::vector<Clock::time_point> deadlines(count);
+  for (auto& deadline : deadlines) {
+    deadline = start + std::chrono::milliseconds(delay_ms(rng));
+  }
+  std::vector<TimerWheel::TimerId> ids(count);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < count; ++i) {
+      ids[i] = wheel.Schedule(deadlines[i], Clock::duration::zero(), [] {});
+    }
+    for (const auto& id : ids) {
+      wheel.Cancel(id);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Runs state.range(0) one-shot timers spread over one second, advancing the
+// wheel tick by tick.
+void BM_TimerExpire(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> delay_ms(1, 1000);
+  std::size_t fired = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    const Clock::time_point start{};
+    TimerWheel wheel(std::chrono::milliseconds(1), start);
+    for (std::size_t i = 0; i < count; ++i) {
+      wheel.Schedule(start + std::chrono::milliseconds(delay_ms(rng)),
+                     Clock::duration::zero(), [&fired] { ++fired; });
+    }
+    state.ResumeTiming();
+    for (int ms = 1; ms <= 1000; ++ms) {
+      wheel.Advance(start + std::chrono::milliseconds(ms));
+    }
+  }
+  benchmark::DoNotOptimize(fired);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+}  // namespace
+
+BENCHMARK(BM_TimerScheduleCancel)->Arg(1 << 10)->Arg(1 << 17);
+BENCHMARK(BM_TimerExpire)->Arg(1 << 10)->Arg(1 << 17);
@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+
+#include <EventHandling/utils/tracer.hpp>
+
+using namespace eh::utils;
+
+namespace {
+
+// What a queue pays per enqueued call while a trace is recorded, and while
+// tracing is compiled in but not recording.
+void BM_TracerRecordEnqueue(benchmark::State& state) {
+  const bool recording = state.range(0) != 0;
+  if (recording) {
+    Tracer::Start();
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Tracer::RecordEnqueue());
+  }
+  Tracer::Stop();
+}
+void BM_TracerRecordExecute(benchmark::State& state) {
+  Tracer::Start();
+  const auto now = Tracer::Clock::now();
+  for (auto _ : state) {
+    Tracer::RecordExecute(1, now, now);
+  }
+  Tracer::Stop();
+}
+}  // namespace
+
+BENCHMARK(BM_TracerRecordEnqueue)->Arg(0)->Arg(1);
+BENCHMARK(BM_TracerRecordExecute);
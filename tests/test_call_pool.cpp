@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/wrapped_call.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+using namespace eh::utils;
+using namespace eh::delegates;
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> processed{0};
+
+void Process(std::size_t count) { processed.fetch_add(count); }
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* block = std::malloc(size == 0 ? 1 : size)) {
+    return block;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+
+TEST(Test_call_pool, test_reuses_released_calls) {
+  InlineInvocable<void, std::size_t> invocable(Process);
+
+  auto first = MakeIntrusive<WrappedCallImpl<void, std::size_t>>(invocable, 1);
+  auto copy = first;
+  void* address = first.get();
+  first.reset();
+  copy->Perform();
+  copy.reset();
+
+  const std::size_t before = allocations.load();
+  auto second = MakeIntrusive<WrappedCallImpl<void, std::size_t>>(invocable, 2);
+  ASSERT_EQ(address, second.get());
+  ASSERT_EQ(before, allocations.load());
+}
+
+TEST(Test_call_pool, test_queued_dispatch_does_not_allocate) {
+  constexpr std::size_t kBurst = 32;
+
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::Spin;
+  auto th = eh::Thread::Create(options);
+  th->Start();
+
+  QueuedInternalExecutor<void, std::size_t> executor(th->CallbackQueue());
+  InlineInvocable<void, std::size_t> invocable(Process);
+
+  // Calls are released by the worker thread and go back to this thread's
+  // pool, so after the first bursts every call reuses a block.
+  auto burst = [&] {
+    const std::size_t target = processed.load() + kBurst;
+    for (std::size_t i = 0; i < kBurst; ++i) {
+      executor.Execute(invocable, 1, InvokeType::Queued);
+    }
+    while (processed.load() < target) {
+      std::this_thread::yield();
+    }
+  };
+
+  for (int i = 0; i < 4; ++i) {
+    burst();
+  }
+  const std::size_t before = allocations.load();
+  for (int i = 0; i < 100; ++i) {
+    burst();
+  }
+  const std::size_t after = allocations.load();
+  th->Stop();
+
+  ASSERT_EQ(before, after);
+}
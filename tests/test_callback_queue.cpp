@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/utils/callback_queue.hpp>
+#include <EventHandling/utils/priority_callback_queue.hpp>
+#include <EventHandling/utils/ring_callback_queue.hpp>
+#include <EventHandling/utils/wrapped_call.hpp>
+
+#include "util_functions.h"
+
+#include <thread>
+#include <vector>
+
+using namespace eh::utils;
+
+size_t counter = 0;
+
+void increaseCounter(size_t value) { counter += value; }
+
+TEST(Test_callback_queue, test_ring_queue_order) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+
+  RingCallbackQueue queue(4);
+  ASSERT_EQ(4, queue.Capacity());
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(nullptr, queue.Get());
+
+  std::vector<IntrusivePtr<WrappedCallImpl<int, int, int>>> calls;
+  for (int i = 0; i < 4; ++i) {
+    calls.push_back(MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(i), 1));
+    ASSERT_TRUE(queue.TryAdd(calls.back()));
+  }
+  ASSERT_FALSE(queue.TryAdd(calls.front()));
+  ASSERT_FALSE(queue.empty());
+
+  for (int i = 0; i < 4; ++i) {
+    auto callback = queue.Get();
+    ASSERT_EQ(calls[i], callback);
+    callback->Perform();
+    ASSERT_EQ(i + 1, calls[i]->Retrieve());
+  }
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(queue.TryAdd(calls.front()));
+}
+
+TEST(Test_callback_queue, test_ring_queue_producers) {
+  counter = 0;
+  auto invocable_function =
+      InvocationElementFactory<void, size_t>::create(increaseCounter);
+
+  constexpr size_t kProducers = 4;
+  constexpr size_t kCallsPerProducer = 1000;
+  RingCallbackQueue queue(64);
+
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < kProducers; ++i) {
+    producers.emplace_back([&] {
+      for (size_t j = 0; j < kCallsPerProducer; ++j) {
+        queue.addCallback(MakeIntrusive<WrappedCallImpl<void, size_t>>(
+            invocable_function, size_t(1)));
+      }
+    });
+  }
+
+  size_t performed = 0;
+  while (performed < kProducers * kCallsPerProducer) {
+    if (auto callback = queue.Get(); callback != nullptr) {
+      callback->Perform();
+      ++performed;
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(kProducers * kCallsPerProducer, counter);
+}
+
+template <typename Queue>
+void CheckDrain() {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+
+  Queue queue;
+  ICallbackQueue::Batch batch;
+  ASSERT_EQ(0, queue.Drain(batch, ICallbackQueue::kDrainAll));
+  ASSERT_TRUE(batch.empty());
+
+  std::vector<IntrusivePtr<WrappedCallImpl<int, int, int>>> calls;
+  for (int i = 0; i < 5; ++i) {
+    calls.push_back(MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(i), 1));
+    queue.addCallback(calls.back());
+  }
+
+  ASSERT_EQ(2, queue.Drain(batch, 2));
+  ASSERT_EQ(2, batch.size());
+  ASSERT_EQ(3, queue.Drain(batch, ICallbackQueue::kDrainAll));
+  ASSERT_EQ(5, batch.size());
+  ASSERT_TRUE(queue.empty());
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    ASSERT_EQ(calls[i], batch[i]);
+  }
+}
+
+TEST(Test_callback_queue, test_drain) {
+  CheckDrain<CallBackQueue>();
+  CheckDrain<RingCallbackQueue>();
+}
+
+TEST(Test_callback_queue, test_requeue_popped_call) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+  auto call = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+      invocable_function, 2, 5);
+  auto other = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+      invocable_function, 1, 1);
+
+  CallBackQueue queue;
+  CallBackQueue second_queue;
+  queue.addCallback(call);
+  ASSERT_THROW(queue.addCallback(call), std::logic_error);
+  ASSERT_THROW(second_queue.addCallback(call), std::logic_error);
+
+  // Popped calls can be queued again, like AwaitedCall does.
+  queue.addCallback(other);
+  ASSERT_EQ(call, queue.Get());
+  queue.addCallback(call);
+  ASSERT_EQ(other, queue.Get());
+  ASSERT_EQ(call, queue.Get());
+  ASSERT_TRUE(queue.empty());
+  second_queue.addCallback(call);
+  ASSERT_EQ(call, second_queue.Get());
+}
+
+template <typename Queue>
+void CheckOverflowPolicies() {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+  auto make_call = [&](int value) {
+    return MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(value), 0);
+  };
+
+  {
+    Queue queue(2, OverflowPolicy::Fail);
+    ASSERT_EQ(EnqueueStatus::Accepted, queue.addCallback(make_call(1)));
+    ASSERT_EQ(EnqueueStatus::Accepted, queue.addCallback(make_call(2)));
+    auto rejected = make_call(3);
+    ASSERT_EQ(EnqueueStatus::Rejected, queue.addCallback(rejected));
+    ASSERT_THROW((void)rejected->Retrieve(), CallbackDroppedError);
+    ASSERT_EQ(1, queue.OverflowCount());
+    ASSERT_EQ(0, queue.DroppedCount());
+  }
+  {
+    Queue queue(2, OverflowPolicy::DropNewest);
+    queue.addCallback(make_call(1));
+    queue.addCallback(make_call(2));
+    auto dropped = make_call(3);
+    ASSERT_EQ(EnqueueStatus::DroppedNewest, queue.addCallback(dropped));
+    ASSERT_THROW((void)dropped->Retrieve(), CallbackDroppedError);
+    ASSERT_EQ(1, queue.DroppedCount());
+
+    ICallbackQueue::Batch batch;
+    ASSERT_EQ(2, queue.Drain(batch, ICallbackQueue::kDrainAll));
+  }
+  {
+    Queue queue(2, OverflowPolicy::DropOldest);
+    auto oldest = make_call(1);
+    queue.addCallback(oldest);
+    queue.addCallback(make_call(2));
+    ASSERT_EQ(EnqueueStatus::DroppedOldest, queue.addCallback(make_call(3)));
+    ASSERT_THROW((void)oldest->Retrieve(), CallbackDroppedError);
+    ASSERT_EQ(1, queue.OverflowCount());
+    ASSERT_EQ(1, queue.DroppedCount());
+
+    ICallbackQueue::Batch batch;
+    ASSERT_EQ(2, queue.Drain(batch, ICallbackQueue::kDrainAll));
+    for (auto& callback : batch) {
+      callback->Perform();
+    }
+    auto first = StaticPointerCast<WrappedCallImpl<int, int, int>>(
+        batch.front());
+    ASSERT_EQ(2, first->Retrieve());
+  }
+  {
+    Queue queue(2, OverflowPolicy::Block);
+    queue.addCallback(make_call(1));
+    queue.addCallback(make_call(2));
+    std::thread producer([&] {
+      ASSERT_EQ(EnqueueStatus::Accepted, queue.addCallback(make_call(3)));
+    });
+    while (queue.OverflowCount() == 0) {
+      std::this_thread::yield();
+    }
+    size_t performed = 0;
+    while (performed < 3) {
+      if (auto callback = queue.Get(); callback != nullptr) {
+        ++performed;
+      }
+    }
+    producer.join();
+    ASSERT_EQ(1, queue.OverflowCount());
+    ASSERT_EQ(0, queue.DroppedCount());
+  }
+}
+
+TEST(Test_callback_queue, test_overflow_policies) {
+  CheckOverflowPolicies<CallBackQueue>();
+  CheckOverflowPolicies<RingCallbackQueue>();
+  CheckOverflowPolicies<PriorityCallbackQueue>();
+}
+
+template <typename Queue>
+void CheckCloseReleasesProducers() {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+  auto make_call = [&](int value) {
+    return MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(value), 0);
+  };
+
+  Queue queue(1, OverflowPolicy::Block);
+  for (size_t i = 0; i < queue.Capacity(); ++i) {
+    queue.addCallback(make_call(1));
+  }
+  auto blocked = make_call(2);
+  EnqueueStatus status = EnqueueStatus::Accepted;
+  std::thread producer([&] { status = queue.addCallback(blocked); });
+  while (queue.OverflowCount() == 0) {
+    std::this_thread::yield();
+  }
+  queue.Close();
+  producer.join();
+  ASSERT_EQ(EnqueueStatus::DroppedNewest, status);
+  ASSERT_THROW((void)blocked->Retrieve(), CallbackDroppedError);
+
+  // Full and closed: no more waiting.
+  ASSERT_EQ(EnqueueStatus::DroppedNewest, queue.addCallback(make_call(3)));
+  queue.Open();
+  ASSERT_NE(nullptr, queue.Get());
+  ASSERT_EQ(EnqueueStatus::Accepted, queue.addCallback(make_call(4)));
+}
+
+TEST(Test_callback_queue, test_close_releases_blocked_producers) {
+  CheckCloseReleasesProducers<CallBackQueue>();
+  CheckCloseReleasesProducers<RingCallbackQueue>();
+  CheckCloseReleasesProducers<PriorityCallbackQueue>();
+}
+
+TEST(Test_callback_queue, test_priority_queue_order) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+  auto make_call = [&](int value, Priority priority) {
+    auto call = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(value), 0);
+    call->SetPriority(priority);
+    return call;
+  };
+
+  PriorityCallbackQueue queue;
+  queue.addCallback(make_call(1, Priority::Low));
+  queue.addCallback(make_call(2, Priority::Normal));
+  queue.addCallback(make_call(3, Priority::Critical));
+  queue.addCallback(make_call(4, Priority::High));
+  queue.addCallback(make_call(5, Priority::Critical));
+
+  ICallbackQueue::Batch batch;
+  ASSERT_EQ(5, queue.Drain(batch, ICallbackQueue::kDrainAll));
+  std::vector<int> order;
+  for (auto& callback : batch) {
+    callback->Perform();
+    order.push_back(
+        StaticPointerCast<WrappedCallImpl<int, int, int>>(callback)
+            ->Retrieve());
+  }
+  ASSERT_EQ((std::vector<int>{3, 5, 4, 2, 1}), order);
+}
+
+TEST(Test_callback_queue, test_priority_queue_starvation) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+
+  PriorityCallbackQueue queue(PriorityCallbackQueue::kUnbounded,
+                              OverflowPolicy::Block, 3);
+  auto low = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+      invocable_function, 0, 0);
+  low->SetPriority(Priority::Low);
+  queue.addCallback(low);
+  for (int i = 0; i < 10; ++i) {
+    auto high = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, 1, 0);
+    high->SetPriority(Priority::High);
+    queue.addCallback(high);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(Priority::High, queue.Get()->GetPriority());
+  }
+  ASSERT_EQ(low, queue.Get());
+  ASSERT_EQ(Priority::High, queue.Get()->GetPriority());
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/awaitable.hpp>
+#include <EventHandling/delegate.hpp>
+#include <EventHandling/event_system.h>
+
+#include "util_functions.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace eh;
+
+namespace {
+
+// Coroutine that starts right away and cleans up after itself.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+void WaitFor(const std::atomic_bool& flag) {
+  while (!flag) {
+    std::this_thread::yield();
+  }
+}
+
+Detached HopBetween(ThreadPtr first, ThreadPtr second,
+                    std::vector<std::thread::id>& visited,
+                    std::atomic_bool& done) {
+  co_await resume_on(first);
+  visited.push_back(std::this_thread::get_id());
+  co_await resume_on(second);
+  visited.push_back(std::this_thread::get_id());
+  // Already there, does not suspend.
+  co_await resume_on(second);
+  visited.push_back(std::this_thread::get_id());
+  done = true;
+}
+
+Detached SumOn(ThreadPtr origin, ThreadPtr target,
+               delegates::Delegate<int, int, int> d, int& result,
+               std::thread::id& resumed_on, std::atomic_bool& done) {
+  co_await resume_on(origin);
+  result = co_await d.InvokeOn(target, 1, 2);
+  resumed_on = std::this_thread::get_id();
+  done = true;
+}
+
+Detached FailOn(ThreadPtr origin, ThreadPtr target, bool& caught,
+                std::atomic_bool& done) {
+  co_await resume_on(origin);
+  auto failing = delegates::delegate<void>(
+      [] { throw std::runtime_error("failed on purpose"); });
+  try {
+    co_await failing.InvokeOn(target);
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  done = true;
+}
+
+Detached CountOn(ThreadPtr origin, ThreadPtr target,
+                 delegates::Delegate<int, int, int> d, std::atomic_int& sum,
+                 std::atomic_int& finished) {
+  co_await resume_on(origin);
+  for (int i = 0; i < 10; ++i) {
+    sum += co_await d.InvokeOn(target, 1, 0);
+  }
+  ++finished;
+}
+
+}  // namespace
+
+TEST(Test_coroutine, test_resume_on) {
+  auto first = Thread::Create();
+  auto second = Thread::Create();
+  first->Start();
+  second->Start();
+
+  std::vector<std::thread::id> visited;
+  std::atomic_bool done{false};
+  HopBetween(first, second, visited, done);
+  WaitFor(done);
+
+  ASSERT_EQ(3, visited.size());
+  ASSERT_EQ(first->ThreadId(), visited[0]);
+  ASSERT_EQ(second->ThreadId(), visited[1]);
+  ASSERT_EQ(second->ThreadId(), visited[2]);
+
+  first->Stop();
+  second->Stop();
+}
+
+TEST(Test_coroutine, test_invoke_on) {
+  EventSystem::Init(1);
+  auto origin = Thread::CreateRegistered();
+  auto target = Thread::CreateRegistered();
+
+  std::thread::id invoked_on;
+  auto d = delegates::delegate<int, int, int>([&invoked_on](int a, int b) {
+    invoked_on = std::this_thread::get_id();
+    return a + b;
+  });
+
+  int result = 0;
+  std::thread::id resumed_on;
+  std::atomic_bool done{false};
+  SumOn(origin, target, d, result, resumed_on, done);
+  WaitFor(done);
+
+  ASSERT_EQ(3, result);
+  ASSERT_EQ(target->ThreadId(), invoked_on);
+  ASSERT_EQ(origin->ThreadId(), resumed_on);
+
+  bool caught = false;
+  done = false;
+  FailOn(origin, target, caught, done);
+  WaitFor(done);
+  ASSERT_TRUE(caught);
+
+  origin->Stop();
+  target->Stop();
+  EventSystem::Release();
+}
+
+TEST(Test_coroutine, test_many_flows) {
+  constexpr int kFlows = 1000;
+
+  EventSystem::Init(1);
+  auto origin = Thread::CreateRegistered();
+  auto target = Thread::CreateRegistered();
+  auto d = delegates::delegate<int, int, int>(Sum);
+
+  // All flows wait at the same time without holding a thread each.
+  std::atomic_int sum{0};
+  std::atomic_int finished{0};
+  for (int i = 0; i < kFlows; ++i) {
+    CountOn(origin, target, d, sum, finished);
+  }
+  while (finished != kFlows) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(10 * kFlows, sum.load());
+
+  origin->Stop();
+  target->Stop();
+  EventSystem::Release();
+}
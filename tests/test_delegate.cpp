@@ -5,6 +5,13 @@
 
 #include "util_functions.h"
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
 using namespace eh::delegates;
 
 TEST(Test_delegate, test_common) {
@@ -56,4 +63,299 @@ TEST(Test_delegate, test_multicast_delegate) {
   md -= delegate_method;
   ASSERT_EQ(4, md(2, 2));
 
-}
\ No newline at end of file
+}
+
+TEST(Test_delegate, test_inline_storage) {
+  SimpleClass s(5);
+  int offset = 3;
+  ASSERT_TRUE((delegate<int, int, int>(Sum).IsInline()));
+  ASSERT_TRUE((delegate<int, int, int>(&s, &SimpleClass::Result).IsInline()));
+  ASSERT_TRUE((delegate<int, int, int>(
+                   [offset](int a, int b) { return a + b + offset; })
+                   .IsInline()));
+
+  std::array<int, 64> table{};
+  table[10] = 4;
+  auto big = delegate<int, int, int>(
+      [table](int a, int b) { return table[static_cast<size_t>(a)] + b; });
+  ASSERT_FALSE(big.IsInline());
+  ASSERT_EQ(6, big(10, 2));
+
+  auto copy = big;
+  ASSERT_EQ(6, copy(10, 2));
+
+  // Copies of a mutable lambda share its state.
+  auto counter = delegate<int>([n = 0]() mutable { return ++n; });
+  auto counter_copy = counter;
+  ASSERT_EQ(1, counter());
+  ASSERT_EQ(2, counter_copy());
+}
+
+TEST(Test_delegate, test_inline_weak_copy) {
+  SimpleClass s(5);
+  using Invocable = eh::utils::InlineInvocable<int, int, int>;
+
+  auto owner = std::make_unique<Invocable>(&s, &SimpleClass::Result);
+  Invocable weak = owner->WeakCopy();
+  auto copy = std::make_unique<Invocable>(*owner);
+  ASSERT_EQ(10, weak(4, 2));
+
+  owner.reset();
+  ASSERT_EQ(10, weak(4, 2));
+  copy.reset();
+  ASSERT_THROW(weak(4, 2), eh::utils::ArgumentPackApplyError);
+}
+
+TEST(Test_delegate, test_lambda_partner) {
+  int calls = 0;
+  auto handler = delegate<void>([&calls] { ++calls; });
+  auto other = delegate<void>([&calls] { ++calls; });
+  auto copy = handler;
+  ASSERT_EQ(handler, copy);
+  ASSERT_NE(handler, other);
+
+  MulticastDelegate<void> md;
+  md += handler;
+  md += other;
+  md -= copy;
+  md();
+  ASSERT_EQ(1, calls);
+}
+
+TEST(Test_delegate, test_multicast_modify_during_invoke) {
+  MulticastDelegate<void> md;
+  int first_calls = 0;
+  int late_calls = 0;
+  auto late = delegate<void>([&late_calls] { ++late_calls; });
+  Delegate<void> first;
+  first = delegate<void>([&] {
+    ++first_calls;
+    md -= first;
+    md += late;
+  });
+  md += first;
+
+  // Changes made by a handler apply from the next invocation on.
+  md();
+  ASSERT_EQ(1, first_calls);
+  ASSERT_EQ(0, late_calls);
+  md();
+  ASSERT_EQ(1, first_calls);
+  ASSERT_EQ(1, late_calls);
+}
+
+TEST(Test_delegate, test_multicast_concurrent_invoke) {
+  constexpr int kInvokers = 4;
+  constexpr int kInvocations = 2000;
+
+  MulticastDelegate<void> md;
+  std::atomic_int permanent_calls{0};
+  md += delegate<void>([&permanent_calls] { ++permanent_calls; });
+
+  std::atomic_bool running{true};
+  std::thread writer([&] {
+    auto transient = delegate<void>([] {});
+    while (running) {
+      md += transient;
+      md -= transient;
+    }
+  });
+  std::vector<std::thread> invokers;
+  for (int i = 0; i < kInvokers; ++i) {
+    invokers.emplace_back([&md] {
+      for (int j = 0; j < kInvocations; ++j) {
+        md();
+      }
+    });
+  }
+  for (auto& invoker : invokers) {
+    invoker.join();
+  }
+  running = false;
+  writer.join();
+
+  ASSERT_EQ(kInvokers * kInvocations, permanent_calls.load());
+}
+
+TEST(Test_delegate, test_multicast_disconnect) {
+  MulticastDelegate<void> md;
+  int first_calls = 0;
+  int second_calls = 0;
+  auto first = md += delegate<void>([&first_calls] { ++first_calls; });
+  auto second = md += delegate<void>([&second_calls] { ++second_calls; });
+  ASSERT_TRUE(first.IsValid());
+  ASSERT_NE(first, second);
+
+  ASSERT_TRUE(md.Disconnect(first));
+  ASSERT_FALSE(md.Disconnect(first));
+  md();
+  ASSERT_EQ(0, first_calls);
+  ASSERT_EQ(1, second_calls);
+
+  // The freed slot is reused, the stale connection must not match it.
+  auto third = md += delegate<void>([] {});
+  ASSERT_FALSE(md.Disconnect(first));
+  ASSERT_TRUE(md.Disconnect(third));
+
+  md.Reset();
+  ASSERT_TRUE(md.IsEmpty());
+  ASSERT_FALSE(md.Disconnect(second));
+  ASSERT_FALSE(md.Disconnect(Connection{}));
+}
+
+TEST(Test_delegate, test_multicast_remove_duplicates) {
+  MulticastDelegate<void> md;
+  int calls = 0;
+  auto handler = delegate<void>([&calls] { ++calls; });
+  auto first = md += handler;
+  auto second = md += handler;
+  auto third = md += handler;
+
+  // -= takes the earliest added of equal handlers.
+  md -= handler;
+  ASSERT_FALSE(md.Disconnect(first));
+  ASSERT_TRUE(md.Disconnect(third));
+  md -= handler;
+  ASSERT_FALSE(md.Disconnect(second));
+  ASSERT_TRUE(md.IsEmpty());
+
+  // A copy can still remove its handlers by value.
+  md += handler;
+  MulticastDelegate<void> copy(md);
+  copy -= handler;
+  ASSERT_TRUE(copy.IsEmpty());
+  md();
+  ASSERT_EQ(1, calls);
+}
+
+TEST(Test_delegate, test_multicast_disconnect_during_invoke) {
+  MulticastDelegate<void> md;
+  int second_calls = 0;
+  Connection second;
+  md += delegate<void>([&] { md.Disconnect(second); });
+  second = md += delegate<void>([&second_calls] { ++second_calls; });
+  md += delegate<void>([] {});
+
+  // A handler removed before its turn does not run.
+  md();
+  ASSERT_EQ(0, second_calls);
+}
+
+TEST(Test_delegate, test_multicast_many_connections) {
+  constexpr int kHandlers = 1000;
+
+  MulticastDelegate<int, int> md;
+  int calls = 0;
+  std::vector<Connection> connections;
+  for (int i = 0; i < kHandlers; ++i) {
+    connections.push_back(md += delegate<int, int>([&calls, i](int value) {
+      ++calls;
+      return value + i;
+    }));
+  }
+  ASSERT_EQ(kHandlers, md(1));
+
+  // Removing every even handler compacts the table on the way.
+  for (int i = 0; i < kHandlers; i += 2) {
+    ASSERT_TRUE(md.Disconnect(connections[i]));
+  }
+  calls = 0;
+  ASSERT_EQ(kHandlers, md(1));
+  ASSERT_EQ(kHandlers / 2, calls);
+
+  // Connections stay valid across compaction.
+  for (int i = 1; i < kHandlers - 1; i += 2) {
+    ASSERT_TRUE(md.Disconnect(connections[i]));
+  }
+  calls = 0;
+  ASSERT_EQ(kHandlers, md(1));
+  ASSERT_EQ(1, calls);
+  ASSERT_TRUE(md.Disconnect(connections.back()));
+  ASSERT_TRUE(md.IsEmpty());
+  ASSERT_THROW(md(1), DelegateException);
+}
+
+TEST(Test_delegate, test_equality_and_hash) {
+  SimpleClass object(2);
+  SimpleClass other_object(2);
+  auto method = delegate<int, int, int>(&object, &SimpleClass::Result);
+  auto same_method = delegate<int, int, int>(&object, &SimpleClass::Result);
+  auto other_method =
+      delegate<int, int, int>(&other_object, &SimpleClass::Result);
+  auto function = delegate<int, int, int>(Sum);
+  auto same_function = delegate<int, int, int>(Sum);
+
+  ASSERT_EQ(method, same_method);
+  ASSERT_EQ(method.Hash(), same_method.Hash());
+  ASSERT_NE(method, other_method);
+  ASSERT_EQ(function, same_function);
+  ASSERT_EQ(function.Hash(), same_function.Hash());
+  ASSERT_NE(function, method);
+
+  // Equality through the interface agrees with the delegate's own.
+  const IDelegate<int, int, int>& base = method;
+  ASSERT_TRUE(base == same_method);
+  ASSERT_FALSE(base == (MulticastDelegate<int, int, int>()));
+
+  // Lambdas with captures are only equal to copies of their delegate.
+  int offset = 1;
+  auto lambda = delegate<int, int, int>(
+      [offset](int a, int b) { return a + b + offset; });
+  auto lambda_copy = lambda;
+  ASSERT_EQ(lambda, lambda_copy);
+  ASSERT_EQ(lambda.Hash(), lambda_copy.Hash());
+
+  std::unordered_set<Delegate<int, int, int>> handlers{method, function,
+                                                       lambda};
+  ASSERT_EQ(1, handlers.count(same_method));
+  ASSERT_EQ(1, handlers.count(same_function));
+  ASSERT_EQ(1, handlers.count(lambda_copy));
+  ASSERT_EQ(0, handlers.count(other_method));
+}
+
+TEST(Test_delegate, test_multicast_remove_by_value) {
+  constexpr int kHandlers = 100;
+
+  std::vector<SimpleClass> objects(kHandlers, SimpleClass(1));
+  MulticastDelegate<int, int, int> md;
+  for (auto& object : objects) {
+    md += delegate<int, int, int>(&object, &SimpleClass::Result);
+  }
+  auto connection = md += delegate<int, int, int>(Sum);
+
+  // Equal delegates created independently find the handler to remove.
+  for (auto& object : objects) {
+    md -= delegate<int, int, int>(&object, &SimpleClass::Result);
+  }
+  ASSERT_EQ(3, md(1, 2));
+  md -= delegate<int, int, int>(Sum);
+  ASSERT_TRUE(md.IsEmpty());
+  ASSERT_FALSE(md.Disconnect(connection));
+}
+
+TEST(Test_delegate, test_bind) {
+  SimpleClass object(5);
+  auto method = bind<&SimpleClass::Result>(&object);
+  static_assert(std::is_same_v<decltype(method), Delegate<int, int, int>>);
+  ASSERT_EQ(25, method(10, 2));
+  ASSERT_TRUE(method.IsInline());
+
+  auto function = bind<&Sum>();
+  ASSERT_EQ(7, function(4, 3));
+  auto static_method = bind<&SimpleClass::Sum>();
+  ASSERT_EQ(7, static_method(4, 3));
+
+  SimpleClass other_object(5);
+  ASSERT_EQ(method, bind<&SimpleClass::Result>(&object));
+  ASSERT_EQ(method.Hash(), bind<&SimpleClass::Result>(&object).Hash());
+  ASSERT_NE(method, bind<&SimpleClass::Result>(&other_object));
+  ASSERT_EQ(function, bind<&Sum>());
+  ASSERT_NE(function, static_method);
+
+  MulticastDelegate<int, int, int> md;
+  md += bind<&Sum>();
+  md += bind<&SimpleClass::Result>(&object);
+  ASSERT_EQ(25, md(10, 2));
+  md -= bind<&SimpleClass::Result>(&object);
+  ASSERT_EQ(12, md(10, 2));
+}
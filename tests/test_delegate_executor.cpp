@@ -7,6 +7,10 @@
 
 #include "util_functions.h"
 
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
 using namespace eh::delegates;
 
 std::thread::id GetCurrentThreadId() { return std::this_thread::get_id(); }
@@ -42,4 +46,187 @@ TEST(Test_delegate_executore, test_with_event_system) {
   ASSERT_EQ(executor.Execute(d1), std::this_thread::get_id());
 
   eh::EventSystem::Release();
-}
\ No newline at end of file
+}
+
+TEST(Test_delegate_executor, test_priority) {
+  eh::EventSystem::Init();
+
+  eh::ThreadOptions options;
+  options.queue_type = eh::CallbackQueueType::Priority;
+  options.batch_size = 1;
+  auto th = eh::Thread::CreateRegistered(options);
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  std::atomic_int done{0};
+  std::vector<int> order;
+
+  auto gate = delegate<void>([&] {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  auto record = delegate<void, int>([&](int value) {
+    order.push_back(value);
+    ++done;
+  });
+  gate.SetThreadId(th->ThreadId());
+  record.SetThreadId(th->ThreadId());
+
+  DelegateExecutor<void> gate_executor(true);
+  DelegateExecutor<void, int> executor(true);
+  gate_executor.Execute(gate);
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  record.SetPriority(Priority::Low);
+  executor.Execute(record, 1);
+  executor.Execute(record, 2);
+  record.SetPriority(Priority::High);
+  executor.Execute(record, 3);
+
+  release = true;
+  while (done != 3) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ((std::vector<int>{3, 1, 2}), order);
+
+  th->Stop();
+  eh::EventSystem::Release();
+}
+
+TEST(Test_delegate_executor, test_queued_future) {
+  eh::EventSystem::Init();
+  auto th = eh::Thread::CreateRegistered();
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  auto gate = delegate<void>([&] {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  auto sum = delegate<int, int, int>(Sum);
+  gate.SetThreadId(th->ThreadId());
+  sum.SetThreadId(th->ThreadId());
+
+  DelegateExecutor<void> gate_executor(true);
+  DelegateExecutor<int, int, int> executor(true);
+  gate_executor.Execute(gate);
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  // The thread is busy, a queued int call still returns right away.
+  auto future = executor.ExecuteQueuedFuture(sum, 1, 5);
+  ASSERT_FALSE(future.IsReady());
+  release = true;
+  ASSERT_EQ(6, future.get());
+
+  // Without the EventSystem to find the thread, the call is performed
+  // right away.
+  DelegateExecutor<int, int, int> direct;
+  ASSERT_EQ(3, direct.ExecuteQueuedFuture(sum, 1, 2).get());
+
+  th->Stop();
+  eh::EventSystem::Release();
+}
+
+TEST(Test_delegate_executor, test_future_then) {
+  auto first = eh::Thread::Create();
+  auto second = eh::Thread::Create();
+  first->Start();
+  second->Start();
+
+  std::thread::id sum_thread;
+  std::thread::id twice_thread;
+  std::thread::id print_thread;
+  auto sum = delegate<int, int, int>([&](int a, int b) {
+    sum_thread = std::this_thread::get_id();
+    return a + b;
+  });
+  auto twice = delegate<int, int>([&](int value) {
+    twice_thread = std::this_thread::get_id();
+    return value * 2;
+  });
+  auto print = delegate<std::string, int>([&](int value) {
+    print_thread = std::this_thread::get_id();
+    return std::to_string(value);
+  });
+
+  auto future =
+      sum.QueueOn(first, 1, 2).Then(second, twice).Then(first, print);
+  ASSERT_EQ("6", future.get());
+  ASSERT_EQ(first->ThreadId(), sum_thread);
+  ASSERT_EQ(second->ThreadId(), twice_thread);
+  ASSERT_EQ(first->ThreadId(), print_thread);
+
+  // Continuing a call that is done already, and one returning void.
+  bool done = false;
+  auto ready = sum.QueueOn(first, 2, 2);
+  ready.wait();
+  ready.Then(second, twice)
+      .Then(first, delegate<void, int>([&](int value) { done = value == 8; }))
+      .get();
+  ASSERT_TRUE(done);
+
+  first->Stop();
+  second->Stop();
+}
+
+TEST(Test_delegate_executor, test_future_then_exception) {
+  auto th = eh::Thread::Create();
+  th->Start();
+
+  bool continued = false;
+  auto fail = delegate<int>([]() -> int { throw std::runtime_error("fail"); });
+  auto next = delegate<int, int>([&](int value) {
+    continued = true;
+    return value;
+  });
+  auto future = fail.QueueOn(th).Then(th, next);
+  ASSERT_THROW(future.get(), std::runtime_error);
+  ASSERT_FALSE(continued);
+
+  th->Stop();
+}
+
+TEST(Test_delegate_executor, test_queued_call_outlives_delegate) {
+  eh::EventSystem::Init();
+  auto th = eh::Thread::CreateRegistered();
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  std::atomic_int calls{0};
+  auto gate = delegate<void>([&] {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  gate.SetThreadId(th->ThreadId());
+  DelegateExecutor<void> executor(true);
+  executor.Execute(gate);
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  {
+    auto handler = delegate<void>([&calls] { ++calls; });
+    handler.SetThreadId(th->ThreadId());
+    executor.Execute(handler);
+  }
+  // The handler is gone before its call runs, so the call must fail.
+  release = true;
+  auto last = delegate<void>([] {});
+  last.SetThreadId(th->ThreadId());
+  last.SetInvokeType(InvokeType::BlockQueued);
+  executor.Execute(last);
+  ASSERT_EQ(0, calls);
+
+  th->Stop();
+  eh::EventSystem::Release();
+}
@@ -2,9 +2,288 @@
 
 #include <EventHandling/event.hpp>
 #include <EventHandling/event_handler.hpp>
+#include <EventHandling/event_system.h>
+#include <EventHandling/static_event.hpp>
 
 #include "util_functions.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace eh;
+
 TEST(Test_events, test_simple_events) {
 
-}
\ No newline at end of file
+}
+
+TEST(Test_events, test_remove_handler_by_connection) {
+  int received = 0;
+  events::Event<int> event;
+  auto first = event.AddHandler(
+      events::handler<int>([&received](int value) { received += value; }));
+  event.AddHandler(
+      events::handler<int>([&received](int value) { received += 10 * value; }));
+
+  event.Trigger(1);
+  ASSERT_EQ(11, received);
+
+  ASSERT_TRUE(event.RemoveHandler(first));
+  ASSERT_FALSE(event.RemoveHandler(first));
+  event.Trigger(1);
+  ASSERT_EQ(21, received);
+}
+
+namespace {
+
+class Counter {
+ public:
+  void Add(int value) { m_total += value; }
+  int Total() const { return m_total; }
+
+ private:
+  int m_total{0};
+};
+
+}  // namespace
+
+TEST(Test_events, test_bound_handler) {
+  Counter counter;
+  events::Event<int> event;
+  event.AddHandler(delegates::bind<&Counter::Add>(&counter));
+  event.Trigger(3);
+  ASSERT_EQ(3, counter.Total());
+
+  event.RemoveHandler(delegates::bind<&Counter::Add>(&counter));
+  ASSERT_FALSE(event.HasHandlers());
+}
+
+namespace {
+
+int static_total = 0;
+
+void AddToTotal(int value) { static_total += value; }
+
+}  // namespace
+
+TEST(Test_events, test_static_event) {
+  static_total = 0;
+  events::StaticEvent<void(int), &AddToTotal,
+                      [](int value) { static_total += 10 * value; }>
+      event;
+  ASSERT_TRUE(event.HasHandlers());
+
+  event.Trigger(1);
+  ASSERT_EQ(11, static_total);
+
+  // Runtime handlers run after the static ones.
+  Counter counter;
+  auto connection =
+      event.AddHandler(delegates::bind<&Counter::Add>(&counter));
+  event.SyncTrigger(2);
+  ASSERT_EQ(33, static_total);
+  ASSERT_EQ(2, counter.Total());
+
+  ASSERT_TRUE(event.RemoveHandler(connection));
+  event.Trigger(1);
+  ASSERT_EQ(44, static_total);
+  ASSERT_EQ(2, counter.Total());
+
+  events::StaticEvent<void(int)> empty;
+  ASSERT_FALSE(empty.HasHandlers());
+  empty.Trigger(1);
+}
+
+TEST(Test_events, test_async_trigger_overflow) {
+  EventSystem::Init();
+
+  ThreadOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = utils::OverflowPolicy::Fail;
+  auto th = Thread::CreateRegistered(options);
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  std::atomic_int received{0};
+  auto h = events::handler<int>([&](int value) {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+    received += value;
+  });
+  h.SetThreadId(th->ThreadId());
+
+  events::Event<int> event;
+  event.AddHandler(h);
+
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.AsyncTrigger(1));
+  while (!started) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.AsyncTrigger(2));
+  ASSERT_EQ(utils::EnqueueStatus::Rejected, event.AsyncTrigger(4));
+  ASSERT_EQ(1, th->CallbackQueue()->OverflowCount());
+
+  release = true;
+  while (received != 3) {
+    std::this_thread::yield();
+  }
+
+  th->Stop();
+  EventSystem::Release();
+}
+
+TEST(Test_events, test_conflating_trigger) {
+  EventSystem::Init();
+
+  ThreadOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = utils::OverflowPolicy::Fail;
+  auto th = Thread::CreateRegistered(options);
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  std::atomic_int calls{0};
+  std::vector<int> received;
+  auto h = events::handler<int>([&](int value) {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+    received.push_back(value);
+    ++calls;
+  });
+  h.SetThreadId(th->ThreadId());
+
+  events::Event<int> event;
+  event.SetTriggerType(events::TriggerType::Conflating);
+  event.AddHandler(h);
+
+  event.Trigger(1);
+  while (!started) {
+    std::this_thread::yield();
+  }
+  // The handler is busy with 1, the rest collapses into a single pending
+  // call and never overflows the one-slot queue.
+  for (int value = 2; value <= 100; ++value) {
+    ASSERT_EQ(utils::EnqueueStatus::Accepted, event.ConflatingTrigger(int{value}));
+  }
+  ASSERT_EQ(0, th->CallbackQueue()->OverflowCount());
+
+  release = true;
+  while (calls < 2) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_EQ(2, calls);
+
+  // Once delivered, the next value is queued again.
+  event.Trigger(101);
+  while (calls < 3) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ((std::vector<int>{1, 100, 101}), received);
+
+  th->Stop();
+  EventSystem::Release();
+}
+
+TEST(Test_events, test_conflating_trigger_after_removal) {
+  EventSystem::Init();
+  auto th = Thread::CreateRegistered();
+
+  std::atomic_bool started{false};
+  std::atomic_bool release{false};
+  auto gate = events::handler<int>([&](int) {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  gate.SetThreadId(th->ThreadId());
+  events::Event<int> gate_event;
+  gate_event.AddHandler(gate);
+  gate_event.AsyncTrigger(0);
+  while (!started) {
+    std::this_thread::yield();
+  }
+
+  std::atomic_int calls{0};
+  std::vector<int> received;
+  auto h = events::handler<int>([&](int value) {
+    received.push_back(value);
+    ++calls;
+  });
+  h.SetThreadId(th->ThreadId());
+  events::Event<int> event;
+  std::vector<delegates::Connection> connections;
+  for (int i = 0; i < 8; ++i) {
+    connections.push_back(event.AddHandler(h));
+  }
+
+  // Removing half of the handlers compacts the others while their calls
+  // are pending, each of them must still get its own call.
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.ConflatingTrigger(1));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(event.RemoveHandler(connections[i]));
+  }
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.ConflatingTrigger(2));
+
+  release = true;
+  while (calls < 4) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_EQ((std::vector<int>{2, 2, 2, 2}), received);
+
+  th->Stop();
+  EventSystem::Release();
+}
+
+TEST(Test_events, test_async_trigger_groups_by_thread) {
+  EventSystem::Init();
+
+  ThreadOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = utils::OverflowPolicy::Fail;
+  auto th = Thread::CreateRegistered(options);
+  auto other = Thread::CreateRegistered(options);
+
+  std::atomic_int sum{0};
+  std::atomic_int on_other{0};
+  events::Event<int> event;
+  for (int i = 0; i < 50; ++i) {
+    auto h = events::handler<int>([&, id = th->ThreadId()](int value) {
+      if (std::this_thread::get_id() == id) {
+        sum += value;
+      }
+    });
+    h.SetThreadId(th->ThreadId());
+    event.AddHandler(h);
+  }
+  auto h = events::handler<int>([&](int value) { on_other += value; });
+  h.SetThreadId(other->ThreadId());
+  auto connection = event.AddHandler(h);
+
+  // One call per thread, so the one-slot queues never overflow.
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.AsyncTrigger(2));
+  while (sum != 100 || on_other != 2) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(0, th->CallbackQueue()->OverflowCount());
+
+  // The grouping follows changes of the handlers.
+  ASSERT_TRUE(event.RemoveHandler(connection));
+  ASSERT_EQ(utils::EnqueueStatus::Accepted, event.AsyncTrigger(1));
+  while (sum != 150) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_EQ(2, on_other);
+
+  th->Stop();
+  other->Stop();
+  EventSystem::Release();
+}
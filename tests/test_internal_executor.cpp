@@ -97,3 +97,21 @@ TEST(Test_internal_executor, test_queued_executor_queued_threaded) {
   th->Stop();
   ASSERT_FALSE(th->IsRunning());
 }
+
+TEST(Test_internal_executor, test_queued_executor_overflow) {
+  auto invocable_function =
+      InvocationElementFactory<void, size_t>::create(increaseCounter);
+
+  auto callback_queue = std::make_shared<CallBackQueue>(1, OverflowPolicy::Fail);
+  QueuedInternalExecutor<void, size_t> executor(callback_queue);
+
+  executor.Execute(invocable_function, 1, InvokeType::Queued);
+  ASSERT_EQ(EnqueueStatus::Accepted, executor.LastEnqueueStatus());
+  executor.Execute(invocable_function, 1, InvokeType::Queued);
+  ASSERT_EQ(EnqueueStatus::Rejected, executor.LastEnqueueStatus());
+  ASSERT_THROW(
+      { executor.Execute(invocable_function, 1, InvokeType::BlockQueued); },
+      CallbackDroppedError);
+  ASSERT_EQ(EnqueueStatus::Rejected, executor.LastEnqueueStatus());
+  ASSERT_EQ(2, callback_queue->OverflowCount());
+}
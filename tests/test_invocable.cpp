@@ -153,3 +153,19 @@ TEST(Test_invocable, test_different_types2) {
   ASSERT_NE(invocable_method, invocable_static_method);
   ASSERT_NE(*invocable_method, *invocable_static_method);
 }
+
+TEST(Test_invocable, test_hash) {
+  SimpleClass object(2);
+  auto method = eh::utils::InvocationElementFactory<int, int, int>::create(
+      &object, &SimpleClass::Result);
+  auto same_method = eh::utils::InvocationElementFactory<int, int, int>::create(
+      &object, &SimpleClass::Result);
+  auto function =
+      eh::utils::InvocationElementFactory<int, int, int>::create(Sum);
+  auto same_function =
+      eh::utils::InvocationElementFactory<int, int, int>::create(Sum);
+
+  ASSERT_EQ(method->hash(), same_method->hash());
+  ASSERT_EQ(function->hash(), same_function->hash());
+  ASSERT_NE(*method, *function);
+}
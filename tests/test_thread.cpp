@@ -0,0 +1,378 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/delegate_internal_executor.hpp>
+#include <EventHandling/event_system.h>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/thread_placement.h>
+#include <EventHandling/utils/invocable_element.hpp>
+#include <EventHandling/utils/tracer.hpp>
+
+#include "util_functions.h"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif  // __linux__
+
+using namespace eh::utils;
+using namespace eh::delegates;
+
+std::thread::id GetCurrentThreadId() { return std::this_thread::get_id(); }
+
+void Noop() {}
+
+TEST(Test_thread, test_idle_strategies) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+
+  for (auto strategy : {eh::IdleStrategy::Spin, eh::IdleStrategy::SpinYield,
+                        eh::IdleStrategy::SpinPark}) {
+    eh::ThreadOptions options;
+    options.idle_strategy = strategy;
+    options.spin_count = 16;
+
+    auto th = eh::Thread::Create(options);
+    th->Start();
+    QueuedInternalExecutor<int, int, int> executor(th->CallbackQueue());
+
+    ASSERT_EQ(7, executor.Execute(invocable_function, 2, 5,
+                                  InvokeType::BlockQueued));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_EQ(9, executor.Execute(invocable_function, 4, 5,
+                                  InvokeType::BlockQueued));
+
+    th->Stop();
+    ASSERT_FALSE(th->IsRunning());
+  }
+}
+
+TEST(Test_thread, test_parked_thread_wakes_up) {
+  eh::ThreadOptions options;
+  options.idle_strategy = eh::IdleStrategy::SpinPark;
+  options.spin_count = 0;
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  auto invocable_function =
+      InvocationElementFactory<std::thread::id>::create(GetCurrentThreadId);
+  QueuedInternalExecutor<std::thread::id> executor(th->CallbackQueue());
+  ASSERT_EQ(th->ThreadId(),
+            executor.Execute(invocable_function, InvokeType::BlockQueued));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  th->Stop();
+  ASSERT_FALSE(th->IsRunning());
+}
+
+TEST(Test_thread, test_ring_queue) {
+  eh::ThreadOptions options;
+  options.queue_type = eh::CallbackQueueType::Ring;
+  options.queue_capacity = 16;
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+
+  auto invocable_function =
+      InvocationElementFactory<std::thread::id>::create(GetCurrentThreadId);
+  QueuedInternalExecutor<std::thread::id> executor(th->CallbackQueue());
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(th->ThreadId(),
+              executor.Execute(invocable_function, InvokeType::BlockQueued));
+  }
+
+  th->Stop();
+}
+
+TEST(Test_thread, test_ring_queue_parked_wake_ups) {
+  constexpr int kProducers = 2;
+  constexpr int kBursts = 2000;
+
+  eh::ThreadOptions options;
+  options.queue_type = eh::CallbackQueueType::Ring;
+  options.queue_capacity = 64;
+  options.idle_strategy = eh::IdleStrategy::SpinPark;
+  options.spin_count = 0;
+
+  auto th = eh::Thread::Create(options);
+  th->Start();
+
+  std::atomic_int performed{0};
+  auto count = InvocationElementFactory<void>::create([&] { ++performed; });
+  auto producer = [&] {
+    QueuedInternalExecutor<void> executor(th->CallbackQueue());
+    for (int i = 0; i < kBursts; ++i) {
+      executor.Execute(count, InvokeType::Queued);
+      // Let the consumer run dry and park between bursts.
+      if (i % 16 == 0) {
+        std::this_thread::yield();
+      }
+    }
+  };
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kProducers; ++i) {
+    producers.emplace_back(producer);
+  }
+  for (auto& p : producers) {
+    p.join();
+  }
+
+  // A lost wake-up leaves calls in the queue of a parked thread.
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (performed.load() < kProducers * kBursts &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(kProducers * kBursts, performed.load());
+  th->Stop();
+}
+
+TEST(Test_thread, test_stop_releases_blocked_producer) {
+  eh::ThreadOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = eh::utils::OverflowPolicy::Block;
+  auto th = eh::Thread::Create(options);
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto noop = InvocationElementFactory<void>::create(Noop);
+
+  // Never started, so nothing frees the single slot.
+  executor.Execute(noop, InvokeType::Queued);
+  std::thread producer([&] {
+    QueuedInternalExecutor<void> blocked(th->CallbackQueue());
+    blocked.Execute(noop, InvokeType::Queued);
+    ASSERT_EQ(EnqueueStatus::DroppedNewest, blocked.LastEnqueueStatus());
+  });
+  while (th->CallbackQueue()->OverflowCount() == 0) {
+    std::this_thread::yield();
+  }
+  th->Stop();
+  producer.join();
+}
+
+TEST(Test_thread, test_metrics) {
+  eh::ThreadOptions options;
+  options.queue_capacity = 4;
+  options.overflow_policy = eh::utils::OverflowPolicy::DropNewest;
+  auto th = eh::Thread::Create(options);
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto noop = InvocationElementFactory<void>::create(Noop);
+
+  // Not started yet: four calls wait, the fifth is dropped.
+  for (int i = 0; i < 5; ++i) {
+    executor.Execute(noop, InvokeType::Queued);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  th->Start();
+  while (!th->CallbackQueue()->empty()) {
+    std::this_thread::yield();
+  }
+  executor.Execute(noop, InvokeType::BlockQueued);
+  // The caller may wake up before the thread records the last call.
+  th->Stop();
+
+  const eh::ThreadMetrics metrics = th->Metrics();
+  ASSERT_EQ(1u, metrics.dropped);
+  if constexpr (eh::utils::kMetricsEnabled) {
+    ASSERT_EQ(5u, metrics.enqueued);
+    ASSERT_EQ(5u, metrics.executed);
+    ASSERT_EQ(0u, metrics.depth);
+    ASSERT_EQ(4u, metrics.high_water);
+    ASSERT_EQ(5u, metrics.queue_wait.count);
+    ASSERT_EQ(5u, metrics.execution.count);
+    // The first four calls waited for Start.
+    ASSERT_GE(metrics.queue_wait.Quantile(0.5),
+              std::chrono::nanoseconds(std::chrono::milliseconds(1)).count());
+  } else {
+    ASSERT_EQ(0u, metrics.enqueued);
+    ASSERT_EQ(0u, metrics.executed);
+    ASSERT_EQ(0u, metrics.queue_wait.count);
+  }
+}
+
+TEST(Test_thread, test_current) {
+  ASSERT_EQ(nullptr, eh::Thread::Current());
+  auto th = eh::Thread::Create();
+  ASSERT_FALSE(th->IsCurrent());
+  th->Start();
+
+  eh::ThreadPtr current;
+  bool is_current = false;
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto probe = InvocationElementFactory<void>::create([&] {
+    current = eh::Thread::Current();
+    is_current = th->IsCurrent();
+  });
+  executor.Execute(probe, InvokeType::BlockQueued);
+  th->Stop();
+
+  ASSERT_EQ(th, current);
+  ASSERT_TRUE(is_current);
+  ASSERT_EQ(nullptr, eh::Thread::Current());
+}
+
+TEST(Test_thread, test_find_registered) {
+  ASSERT_FALSE(eh::Thread::FindRegistered(std::this_thread::get_id()));
+  eh::EventSystem::Init(1);
+  auto main_thread = eh::EventSystem::MainThread();
+  ASSERT_EQ(main_thread, eh::Thread::FindRegistered(main_thread->ThreadId()));
+
+  // Lookups keep working while other threads register.
+  std::atomic_bool done{false};
+  std::thread reader([&] {
+    while (!done) {
+      ASSERT_EQ(main_thread,
+                eh::Thread::FindRegistered(main_thread->ThreadId()));
+    }
+  });
+  std::vector<eh::ThreadPtr> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.push_back(eh::Thread::CreateRegistered());
+  }
+  done = true;
+  reader.join();
+
+  for (const auto& th : threads) {
+    ASSERT_EQ(th, eh::Thread::FindRegistered(th->ThreadId()));
+    th->Stop();
+  }
+  ASSERT_FALSE(eh::Thread::FindRegistered(std::this_thread::get_id()));
+  eh::EventSystem::Release();
+}
+
+#ifdef __linux__
+TEST(Test_thread, test_placement) {
+  const std::vector<std::size_t> node_cpus = eh::NumaNodeCpus(0);
+  eh::ThreadOptions options;
+  options.name = "eh-placement-test";
+  options.cpu_affinity = {0};
+  options.nice = 1;
+  if (!node_cpus.empty()) {
+    options.numa_node = 0;
+  }
+  auto th = eh::Thread::Create(options);
+  th->Start();
+
+  int cpu = -1;
+  char name[16] = {};
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto probe = InvocationElementFactory<void>::create([&cpu, &name] {
+    cpu = sched_getcpu();
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+  });
+  executor.Execute(probe, InvokeType::BlockQueued);
+  th->Stop();
+
+  ASSERT_EQ(0, cpu);
+  ASSERT_EQ(std::string("eh-placement-te"), name);
+}
+
+TEST(Test_thread, test_placement_refused) {
+  eh::ThreadOptions options;
+  options.cpu_affinity = {1 << 20};
+  auto th = eh::Thread::Create(options);
+  ASSERT_THROW(th->Start(), std::system_error);
+  ASSERT_FALSE(th->IsRunning());
+
+  options.cpu_affinity.clear();
+  options.numa_node = 1 << 20;
+  ASSERT_THROW(eh::Thread::Create(options), std::system_error);
+}
+#endif  // __linux__
+
+TEST(Test_thread, test_tracer) {
+  Tracer::Start();
+  const std::uint64_t flow = Tracer::RecordEnqueue();
+  ASSERT_NE(0u, flow);
+  std::thread([flow] {
+    const auto now = Tracer::Clock::now();
+    Tracer::RecordExecute(flow, now, now + std::chrono::microseconds(5));
+  }).join();
+  Tracer::Stop();
+  ASSERT_EQ(0u, Tracer::RecordEnqueue());
+
+  std::ostringstream out;
+  Tracer::WriteChromeTrace(out);
+  const std::string trace = out.str();
+  const std::string id = "\"id\":" + std::to_string(flow);
+  ASSERT_NE(std::string::npos, trace.find("\"traceEvents\""));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"enqueue\""));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"execute\""));
+  ASSERT_NE(std::string::npos, trace.find("\"dur\":5.000"));
+  ASSERT_NE(std::string::npos, trace.find("\"ph\":\"s\""));
+  ASSERT_NE(std::string::npos, trace.find("\"ph\":\"f\""));
+  ASSERT_NE(trace.find(id), trace.rfind(id));
+}
+
+TEST(Test_thread, test_tracer_overwrites_oldest) {
+  Tracer::Start(3);
+  std::uint64_t first = 0;
+  for (int i = 0; i < 10; ++i) {
+    const std::uint64_t flow = Tracer::RecordEnqueue();
+    first = first == 0 ? flow : first;
+  }
+  Tracer::Stop();
+
+  // The ring is rounded up to 4 events.
+  std::ostringstream out;
+  Tracer::WriteChromeTrace(out);
+  const std::string trace = out.str();
+  std::size_t slices = 0;
+  for (auto pos = trace.find("\"enqueue\""); pos != std::string::npos;
+       pos = trace.find("\"enqueue\"", pos + 1)) {
+    ++slices;
+  }
+  ASSERT_EQ(4u, slices);
+  ASSERT_EQ(std::string::npos,
+            trace.find("\"id\":" + std::to_string(first) + ","));
+}
+
+TEST(Test_thread, test_tracing_queued_calls) {
+  if constexpr (!kTracingEnabled) {
+    GTEST_SKIP() << "built without EH_ENABLE_TRACING";
+  }
+  auto th = eh::Thread::Create();
+  QueuedInternalExecutor<void> executor(th->CallbackQueue());
+  auto noop = InvocationElementFactory<void>::create(Noop);
+  th->Start();
+  Tracer::Start();
+  executor.Execute(noop, InvokeType::BlockQueued);
+  // The caller may wake up before the thread records the call.
+  th->Stop();
+  Tracer::Stop();
+
+  std::ostringstream out;
+  Tracer::WriteChromeTrace(out);
+  const std::string trace = out.str();
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"enqueue\""));
+  ASSERT_NE(std::string::npos, trace.find("\"name\":\"execute\""));
+  ASSERT_NE(std::string::npos, trace.find("\"ph\":\"f\""));
+}
+
+TEST(Test_thread, test_log_histogram) {
+  LogHistogram histogram;
+  histogram.Record(std::chrono::nanoseconds(0));
+  histogram.Record(std::chrono::nanoseconds(1));
+  histogram.Record(std::chrono::nanoseconds(100));
+  histogram.Record(std::chrono::nanoseconds(1000));
+
+  const HistogramSnapshot snapshot = histogram.Snapshot();
+  ASSERT_EQ(4u, snapshot.count);
+  ASSERT_EQ(1101u, snapshot.sum_ns);
+  ASSERT_EQ(1u, snapshot.counts[0]);
+  ASSERT_EQ(1u, snapshot.counts[1]);
+  ASSERT_EQ(1u, snapshot.counts[7]);
+  ASSERT_EQ(1u, snapshot.counts[10]);
+  ASSERT_EQ(0u, snapshot.Quantile(0.25));
+  ASSERT_EQ(127u, snapshot.Quantile(0.75));
+  ASSERT_EQ(1023u, snapshot.Quantile(1.0));
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/delegate.hpp>
+#include <EventHandling/thread.hpp>
+#include <EventHandling/utils/timer_wheel.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace eh;
+using namespace eh::utils;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = TimerWheel::Clock;
+
+const Clock::time_point kStart{};
+
+Clock::time_point At(std::int64_t ms) {
+  return kStart + std::chrono::milliseconds(ms);
+}
+
+}  // namespace
+
+TEST(Test_timer_wheel, test_fires_at_deadline) {
+  TimerWheel wheel(1ms, kStart);
+  std::vector<int> fired;
+  wheel.Schedule(At(5), Clock::duration::zero(), [&] { fired.push_back(5); });
+  wheel.Schedule(At(3), Clock::duration::zero(), [&] { fired.push_back(3); });
+  ASSERT_EQ(2u, wheel.Size());
+  ASSERT_EQ(At(3), wheel.NextDeadline());
+
+  ASSERT_EQ(0u, wheel.Advance(At(2)));
+  ASSERT_EQ(1u, wheel.Advance(At(4)));
+  ASSERT_EQ(std::vector<int>{3}, fired);
+  ASSERT_EQ(1u, wheel.Advance(At(10)));
+  ASSERT_EQ((std::vector<int>{3, 5}), fired);
+  ASSERT_TRUE(wheel.Empty());
+  ASSERT_EQ(Clock::time_point::max(), wheel.NextDeadline());
+}
+
+TEST(Test_timer_wheel, test_cascades_across_levels) {
+  TimerWheel wheel(1ms, kStart);
+  std::vector<std::int64_t> deadlines = {300, 255, 256, 70000, 20000000,
+                                         5000000000};
+  std::vector<std::int64_t> fired;
+  for (auto deadline : deadlines) {
+    wheel.Schedule(At(deadline), Clock::duration::zero(),
+                   [&fired, deadline] { fired.push_back(deadline); });
+  }
+  // Timers must neither fire early nor be lost while moving down the levels.
+  for (auto deadline : {255, 256, 300, 70000, 20000000}) {
+    wheel.Advance(At(deadline - 1));
+    ASSERT_TRUE(fired.empty() || fired.back() < deadline);
+    wheel.Advance(At(deadline));
+    ASSERT_EQ(deadline, fired.back());
+  }
+  ASSERT_EQ(1u, wheel.Size());
+  wheel.Advance(At(5000000000));
+  ASSERT_EQ(5000000000, fired.back());
+  ASSERT_EQ(deadlines.size(), fired.size());
+}
+
+TEST(Test_timer_wheel, test_cancel) {
+  TimerWheel wheel(1ms, kStart);
+  int fired = 0;
+  auto first = wheel.Schedule(At(10), Clock::duration::zero(), [&] { ++fired; });
+  auto second =
+      wheel.Schedule(At(1000), Clock::duration::zero(), [&] { ++fired; });
+  ASSERT_TRUE(wheel.Cancel(first));
+  ASSERT_FALSE(wheel.Cancel(first));
+  ASSERT_TRUE(wheel.Cancel(second));
+  ASSERT_TRUE(wheel.Empty());
+  wheel.Advance(At(2000));
+  ASSERT_EQ(0, fired);
+
+  // A reused node must not be cancelled through a stale id.
+  auto third = wheel.Schedule(At(2010), Clock::duration::zero(), [&] { ++fired; });
+  ASSERT_EQ(second.index, third.index);
+  ASSERT_FALSE(wheel.Cancel(second));
+  wheel.Advance(At(2010));
+  ASSERT_EQ(1, fired);
+  ASSERT_FALSE(wheel.Cancel(third));
+}
+
+TEST(Test_timer_wheel, test_periodic) {
+  TimerWheel wheel(1ms, kStart);
+  int fired = 0;
+  auto id = wheel.Schedule(At(10), 10ms, [&] { ++fired; });
+  for (int ms = 1; ms <= 100; ++ms) {
+    wheel.Advance(At(ms));
+  }
+  ASSERT_EQ(10, fired);
+
+  // Missed periods are skipped, not replayed.
+  wheel.Advance(At(1000));
+  ASSERT_EQ(11, fired);
+  wheel.Advance(At(1009));
+  ASSERT_EQ(11, fired);
+  wheel.Advance(At(1010));
+  ASSERT_EQ(12, fired);
+
+  ASSERT_TRUE(wheel.Cancel(id));
+  wheel.Advance(At(2000));
+  ASSERT_EQ(12, fired);
+}
+
+TEST(Test_timer_wheel, test_callbacks_may_reschedule_and_throw) {
+  TimerWheel wheel(1ms, kStart);
+  int fired = 0;
+  TimerWheel::TimerId id;
+  id = wheel.Schedule(At(1), 1ms, [&] {
+    if (++fired == 3) {
+      wheel.Cancel(id);
+    }
+  });
+  wheel.Schedule(At(2), Clock::duration::zero(),
+                 [] { throw std::runtime_error("timer"); });
+  for (int ms = 1; ms <= 10; ++ms) {
+    wheel.Advance(At(ms));
+  }
+  ASSERT_EQ(3, fired);
+  ASSERT_TRUE(wheel.Empty());
+}
+
+TEST(Test_timer_wheel, test_thread_post_after) {
+  auto th = Thread::Create();
+  th->Start();
+  std::atomic<std::thread::id> fired_on{};
+  const auto start = Clock::now();
+  std::atomic<Clock::time_point> fired_at{};
+  th->PostAfter(20ms, delegates::delegate<void>([&] {
+                  fired_at = Clock::now();
+                  fired_on = std::this_thread::get_id();
+                }));
+  while (fired_on.load() == std::thread::id()) {
+    std::this_thread::sleep_for(1ms);
+  }
+  ASSERT_EQ(th->ThreadId(), fired_on.load());
+  ASSERT_GE(fired_at.load() - start, 20ms);
+
+  auto cancelled = th->PostAfter(10ms, delegates::delegate<void>([&] {
+                                   fired_on = std::thread::id();
+                                 }));
+  ASSERT_TRUE(th->CancelTimer(cancelled));
+  std::this_thread::sleep_for(30ms);
+  ASSERT_EQ(th->ThreadId(), fired_on.load());
+  th->Stop();
+}
+
+TEST(Test_timer_wheel, test_thread_post_every) {
+  auto th = Thread::Create();
+  th->Start();
+  std::atomic_int fired{0};
+  auto id = th->PostEvery(2ms, delegates::delegate<void>([&] { ++fired; }));
+  while (fired < 5) {
+    std::this_thread::sleep_for(1ms);
+  }
+  ASSERT_TRUE(th->CancelTimer(id));
+  const int after_cancel = fired;
+  std::this_thread::sleep_for(20ms);
+  // The callback may have been running while it was cancelled.
+  ASSERT_LE(fired - after_cancel, 1);
+  th->Stop();
+
+  ASSERT_THROW(th->PostAfter(1ms, delegates::Delegate<void>()),
+               delegates::DelegateException);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <EventHandling/delegate_executor.hpp>
+#include <EventHandling/event_system.h>
+#include <EventHandling/worker_pool.hpp>
+
+#include "util_functions.h"
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace eh::utils;
+using namespace eh::delegates;
+
+std::thread::id GetCurrentThreadId() { return std::this_thread::get_id(); }
+
+TEST(Test_worker_pool, test_submit) {
+  eh::WorkerPool pool(3);
+  ASSERT_EQ(3, pool.Size());
+  ASSERT_FALSE(pool.IsWorkerThread());
+
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+  std::vector<Future<int>> futures;
+  for (int i = 0; i < 100; ++i) {
+    auto call = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+        invocable_function, int(i), 1);
+    futures.push_back(call->GetFuture());
+    pool.Submit(call);
+  }
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(i + 1, futures[i].get());
+  }
+}
+
+TEST(Test_worker_pool, test_nested_submit) {
+  eh::WorkerPool pool(2);
+  std::atomic_int counter{0};
+  std::promise<void> done;
+
+  auto inner = InvocationElementFactory<void>::create([&] {
+    if (++counter == 10) {
+      done.set_value();
+    }
+  });
+  auto outer = InvocationElementFactory<void>::create([&] {
+    ASSERT_TRUE(pool.IsWorkerThread());
+    for (int i = 0; i < 10; ++i) {
+      pool.Submit(MakeIntrusive<WrappedCallImpl<void>>(inner));
+    }
+  });
+  pool.Submit(MakeIntrusive<WrappedCallImpl<void>>(outer));
+  done.get_future().get();
+  ASSERT_EQ(10, counter);
+}
+
+TEST(Test_worker_pool, test_async_invoke) {
+  eh::EventSystem::Init(2);
+
+  Delegate<std::thread::id> d = delegate<std::thread::id>(GetCurrentThreadId);
+  d.SetInvokeType(InvokeType::Async);
+  DelegateExecutor<std::thread::id> executor;
+
+  ASSERT_NE(std::this_thread::get_id(), executor.Execute(d));
+
+  auto future = executor.ExecuteAsync(d);
+  ASSERT_NE(std::this_thread::get_id(), future.get());
+
+  eh::EventSystem::Release();
+}
+
+TEST(Test_worker_pool, test_async_future_without_event_system) {
+  ASSERT_FALSE(eh::EventSystem::IsInitialized());
+
+  Delegate<std::thread::id> d = delegate<std::thread::id>(GetCurrentThreadId);
+  DelegateExecutor<std::thread::id> executor;
+  ASSERT_EQ(std::this_thread::get_id(), executor.ExecuteAsync(d).get());
+
+  Delegate<void> fail =
+      delegate<void>([] { throw std::runtime_error("fail"); });
+  DelegateExecutor<void> void_executor;
+  ASSERT_THROW(void_executor.ExecuteAsync(fail).get(), std::runtime_error);
+}
+
+TEST(Test_worker_pool, test_async_void_does_not_wait) {
+  eh::EventSystem::Init(2);
+
+  std::promise<void> release;
+  std::promise<void> finished;
+  auto released = release.get_future();
+  Delegate<void> d = delegate<void>([&] {
+    released.wait();
+    finished.set_value();
+  });
+  d.SetInvokeType(InvokeType::Async);
+  DelegateExecutor<void> executor;
+
+  // Blocks forever if Execute waited for the call.
+  executor.Execute(d);
+  release.set_value();
+  finished.get_future().wait();
+
+  eh::EventSystem::Release();
+}
+
+#ifdef __linux__
+TEST(Test_worker_pool, test_release_joins_workers) {
+  const auto thread_count = [] {
+    return std::distance(std::filesystem::directory_iterator("/proc/self/task"),
+                         std::filesystem::directory_iterator());
+  };
+  const auto before = thread_count();
+  for (int i = 0; i < 3; ++i) {
+    eh::EventSystem::Init(4);
+    auto th = eh::Thread::CreateRegistered();
+    ASSERT_LT(before, thread_count());
+    eh::EventSystem::Release();
+    ASSERT_FALSE(th->IsRunning());
+  }
+  ASSERT_EQ(before, thread_count());
+}
+#endif  // __linux__
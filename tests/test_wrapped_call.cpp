@@ -4,6 +4,9 @@
 
 #include "util_functions.h"
 
+#include <chrono>
+#include <thread>
+
 using namespace eh::utils;
 
 TEST(Test_wrapped_call, test_common) {
@@ -35,8 +38,37 @@ TEST(Test_wrapped_call, test_use_future) {
   auto invocable_function =
       InvocationElementFactory<int, int, int>::create(Sum);
 
-  WrappedCallImpl<int, int, int> call(invocable_function, 2, 5);
-  auto future = call.GetFuture();
-  call.Perform();
+  auto call = MakeIntrusive<WrappedCallImpl<int, int, int>>(invocable_function,
+                                                            2, 5);
+  auto future = call->GetFuture();
+  ASSERT_FALSE(future.IsReady());
+  call->Perform();
+  ASSERT_TRUE(future.IsReady());
   ASSERT_EQ(7, future.get());
+  ASSERT_FALSE(future.valid());
+
+  WrappedCallImpl<int, int, int> unowned(invocable_function, 2, 5);
+  ASSERT_THROW((void)unowned.GetFuture(), std::logic_error);
+}
+
+TEST(Test_wrapped_call, test_wait_from_other_thread) {
+  auto invocable_function =
+      InvocationElementFactory<int, int, int>::create(Sum);
+
+  auto call = MakeIntrusive<WrappedCallImpl<int, int, int>>(invocable_function,
+                                                            2, 5);
+  auto future = call->GetFuture();
+  std::thread producer([call] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    call->Perform();
+  });
+  ASSERT_EQ(7, future.get());
+  producer.join();
+
+  auto dropped = MakeIntrusive<WrappedCallImpl<int, int, int>>(
+      invocable_function, 2, 5);
+  auto dropped_future = dropped->GetFuture();
+  std::thread discarder([dropped] { dropped->Discard(); });
+  ASSERT_THROW((void)dropped_future.get(), CallbackDroppedError);
+  discarder.join();
 }